@@ -0,0 +1,272 @@
+#include <xc.h>
+#include "HEADER.h"
+
+/*
+ * Calibration. Everything that has to be retuned for a different chassis or
+ * floor (motor trims, IR thresholds, the baud rate calibration, steering
+ * gains, motor slew and the speed regulator's full speed back-EMF) is kept
+ * in one block, 'cal', which the rest of the
+ * program reads instead of constants.
+ *
+ * In the data EEPROM at CAL_ADDRESS the block is CAL_BYTES long, 16 bit
+ * values low byte first:
+ *
+ *   version | rightTrim | leftTrim | irAheadLow (2) | irAheadHigh (2) |
+ *   irLostCap1 (2) | irLostCap2 (2) | spbrg | slew | kp (2) | ki (2) |
+ *   kd (2) | emfFull (2) | CRC-16 (2)
+ *
+ * which is how XC8 lays out struct calibration, but is packed and unpacked
+ * a field at a time so it does not depend on the compiler (the host
+ * simulator's ints are 32 bits). calLoad() only uses a block whose version
+ * is CAL_VERSION, whose CRC-16 matches and whose values are all within the
+ * CAL_ limits; otherwise the compiled defaults (CAL_* in HEADER.h) are used.
+ *
+ * To retune a robot without reflashing it, a PC on the serial line (in place
+ * of the RFID reader, while the robot is looking for the beacon) sends
+ * CAL_WRITE_BYTE and then a whole block, which sim/calblock.c makes from
+ * the defaults and the values given to it. The block goes through the same
+ * checks; if it passes it is used straight away (the baud rate from the next
+ * reset) and saved to the EEPROM by calStep() in the background, a byte
+ * whenever the last write has finished. Bytes that already hold the right
+ * value are not written again. A save cut short by a power cut leaves a
+ * block whose CRC does not match, so the defaults are used until it is sent
+ * again.
+ *
+ * After start-up and after each block received, the block in use goes out
+ * as a TELEM_CAL record with how it got there (CAL_DEFAULTS, CAL_LOADED,
+ * CAL_WRITTEN or CAL_REJECTED); sim/telemcsv.c prints it.
+ */
+
+#define CAL_CRC_AT (CAL_BYTES - 2) // where the CRC is in the block
+#define CAL_IDLE 0xFF           // not receiving a block
+
+struct calibration cal;
+
+static unsigned char calBlock[CAL_BYTES]; // the block in use, as it is saved
+static unsigned char calRx[CAL_BYTES]; // block being received
+static unsigned char calRxCount = CAL_IDLE; // bytes of it so far
+static uint16_t calRxLast; // tick the last of them came
+static unsigned char calSavePos = CAL_BYTES; // next byte to save, CAL_BYTES when not saving
+static unsigned char calStatus = CAL_DEFAULTS; // how the block in use got there (CAL_DEFAULTS...)
+static char calReport = 0; // a TELEM_CAL record is waiting to go
+
+//Function to read one byte of the data EEPROM
+unsigned char eeRead(unsigned char address) {
+    EEADR = address;
+    EECON1bits.EEPGD = 0; // data EEPROM, not program memory
+    EECON1bits.CFGS = 0;
+    EECON1bits.RD = 1;
+    return EEDATA;
+}
+
+//Function to check whether a data EEPROM write is still going on
+char eeBusy(void) {
+    if (EECON1bits.WR) {
+        return 1;
+    }
+    EECON1bits.WREN = 0; // no more writes until the next one is set up
+    return 0;
+}
+
+//Function to start writing one byte of the data EEPROM, returns straight away (the write takes about 4ms, see eeBusy)
+void eeWriteStart(unsigned char address, unsigned char data) {
+    unsigned char gie;
+
+    EEADR = address;
+    EEDATA = data;
+    EECON1bits.EEPGD = 0;
+    EECON1bits.CFGS = 0;
+    EECON1bits.WREN = 1;
+
+    gie = INTCON & 0xC0; // GIEH/GIEL as they were
+    INTCON &= 0x3F; // the unlock sequence must not be interrupted
+    EECON2 = 0x55;
+    EECON2 = 0xAA;
+    EECON1bits.WR = 1;
+    INTCON |= gie;
+}
+
+//Function to work out the CRC-16 (CCITT) of a block, not counting the CRC itself
+static unsigned int calCRC(const unsigned char *b) {
+    unsigned int crc = 0xFFFF;
+
+    for (unsigned char i = 0; i < CAL_CRC_AT; i++) {
+        crc ^= (unsigned int) b[i] << 8;
+        for (unsigned char bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return (uint16_t) crc; //16 bits, whatever the size of an int
+}
+
+//Function to read a 16 bit value from a block
+static unsigned int calWord(const unsigned char *b) {
+    return b[0] | (unsigned int) b[1] << 8;
+}
+
+//Function to write a 16 bit value into a block
+static void calPutWord(unsigned char *b, unsigned int value) {
+    b[0] = value;
+    b[1] = value >> 8;
+}
+
+//Function to lay 'cal' out as a block, with its CRC
+static void calPack(unsigned char *b) {
+    b[0] = CAL_VERSION;
+    b[1] = cal.rightTrim;
+    b[2] = cal.leftTrim;
+    calPutWord(b + 3, cal.irAheadLow);
+    calPutWord(b + 5, cal.irAheadHigh);
+    calPutWord(b + 7, cal.irLostCap1);
+    calPutWord(b + 9, cal.irLostCap2);
+    b[11] = cal.spbrg;
+    b[12] = cal.slew;
+    calPutWord(b + 13, cal.kp);
+    calPutWord(b + 15, cal.ki);
+    calPutWord(b + 17, cal.kd);
+    calPutWord(b + 19, cal.emfFull);
+    calPutWord(b + CAL_CRC_AT, calCRC(b));
+}
+
+//Function to check the values of a block are ones the robot can run with
+static char calInRange(struct calibration *c) {
+    return c->rightTrim >= -CAL_TRIM_MAX && c->rightTrim <= CAL_TRIM_MAX
+            && c->leftTrim >= -CAL_TRIM_MAX && c->leftTrim <= CAL_TRIM_MAX
+            && c->irAheadLow <= c->irAheadHigh
+            && c->irLostCap1 < c->irAheadLow && c->irLostCap2 < c->irAheadLow
+            && c->spbrg >= CAL_SPBRG_MIN && c->spbrg <= CAL_SPBRG_MAX
+            && c->slew >= CAL_SLEW_MIN && c->slew <= CAL_SLEW_MAX
+            && c->kp >= 0 && c->kp <= CAL_GAIN_MAX
+            && c->ki >= 0 && c->ki <= CAL_GAIN_MAX
+            && c->kd >= 0 && c->kd <= CAL_GAIN_MAX
+            && c->emfFull >= CAL_EMF_FULL_MIN && c->emfFull <= CAL_EMF_FULL_MAX;
+}
+
+//Function to take a block into 'cal', returns 0 (and leaves 'cal' alone) if it is damaged or out of range
+static char calUnpack(const unsigned char *b) {
+    struct calibration c;
+
+    if (b[0] != CAL_VERSION || calWord(b + CAL_CRC_AT) != calCRC(b)) {
+        return 0;
+    }
+    c.version = b[0];
+    c.rightTrim = b[1];
+    c.leftTrim = b[2];
+    c.irAheadLow = calWord(b + 3);
+    c.irAheadHigh = calWord(b + 5);
+    c.irLostCap1 = calWord(b + 7);
+    c.irLostCap2 = calWord(b + 9);
+    c.spbrg = b[11];
+    c.slew = b[12];
+    c.kp = (int16_t) calWord(b + 13);
+    c.ki = (int16_t) calWord(b + 15);
+    c.kd = (int16_t) calWord(b + 17);
+    c.emfFull = calWord(b + 19);
+    if (!calInRange(&c)) {
+        return 0;
+    }
+    cal = c;
+    return 1;
+}
+
+//Function to set the block to the compiled defaults
+void calDefaults(void) {
+    cal.version = CAL_VERSION;
+    cal.rightTrim = 0;
+    cal.leftTrim = 0;
+    cal.irAheadLow = CAL_IR_AHEAD_LOW;
+    cal.irAheadHigh = CAL_IR_AHEAD_HIGH;
+    cal.irLostCap1 = CAL_IR_LOST_CAP1;
+    cal.irLostCap2 = CAL_IR_LOST_CAP2;
+    cal.spbrg = CAL_SPBRG;
+    cal.slew = MOTOR_SLEW;
+    cal.kp = STEER_KP;
+    cal.ki = STEER_KI;
+    cal.kd = STEER_KD;
+    cal.emfFull = CAL_EMF_FULL;
+}
+
+//Function to load the block from the EEPROM, returns 0 (and uses the defaults) if it is missing, damaged or out of range
+char calLoad(void) {
+    for (unsigned char i = 0; i < CAL_BYTES; i++) {
+        calBlock[i] = eeRead(CAL_ADDRESS + i);
+    }
+
+    calReport = 1; // which went out with the first telemetry
+    if (!calUnpack(calBlock)) {
+        calDefaults();
+        calPack(calBlock);
+        calStatus = CAL_DEFAULTS;
+        return 0;
+    }
+    calStatus = CAL_LOADED;
+    return 1;
+}
+
+//Function to start taking a block from the serial line
+void calWriteStart(void) {
+    calRxCount = 0;
+    calRxLast = schedTicks();
+}
+
+//Function to take a byte of a block from the serial line, returns 0 if it is not part of one
+char calReceive(unsigned char byte) {
+    if (calRxCount == CAL_IDLE) {
+        return 0;
+    }
+    calRxLast = schedTicks();
+    calRx[calRxCount++] = byte;
+    if (calRxCount < CAL_BYTES) {
+        return 1;
+    }
+
+    calRxCount = CAL_IDLE;
+    if (calUnpack(calRx)) { // used from here on
+        for (unsigned char i = 0; i < CAL_BYTES; i++) {
+            calBlock[i] = calRx[i];
+        }
+        calSavePos = 0; // (from the start, if a save was going on)
+        calStatus = CAL_WRITTEN;
+    } else {
+        calStatus = CAL_REJECTED;
+    }
+    calReport = 1;
+    return 1;
+}
+
+//Function to drop a block that stopped coming and carry on saving the last one, run every 1ms. Writes the next byte that needs it once the last write is done
+void calStep(void) {
+    if (calRxCount != CAL_IDLE && (uint16_t) (schedTicks() - calRxLast) > RFID_TIMEOUT_TICKS) {
+        calRxCount = CAL_IDLE; // the rest of the block never came
+        calStatus = CAL_REJECTED;
+        calReport = 1;
+    }
+
+    if (calSavePos >= CAL_BYTES || eeBusy()) {
+        return;
+    }
+    while (calSavePos < CAL_BYTES) {
+        if (eeRead(CAL_ADDRESS + calSavePos) != calBlock[calSavePos]) { // unchanged bytes are not written again
+            eeWriteStart(CAL_ADDRESS + calSavePos, calBlock[calSavePos]);
+            calSavePos++;
+            return;
+        }
+        calSavePos++;
+    }
+}
+
+//Function to check whether a block is still being saved
+char calSaving(void) {
+    return calSavePos < CAL_BYTES;
+}
+
+//Function to queue the calibration report, returns 0 if there is nothing to send
+char calReportNext(void) {
+    if (!calReport) {
+        return 0;
+    }
+    if (telemCal(calStatus, calBlock)) { // otherwise sent again next time
+        calReport = 0;
+    }
+    return 1;
+}
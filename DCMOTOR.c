@@ -14,9 +14,18 @@
 /*
  * The power figures appear to be very inconsistent due to the constant
  * tweaking to compensate for terrain-related issues and non-ideal motors.
+ * With the speed regulator (SPEED.c) each motor runs at the speed its power
+ * asks for, whatever the battery and the floor, so the movements that should
+ * go straight or spin on the spot have the same power on both sides. With
+ * SPEED 0 the table keeps the powers found on the robot (MOTION_POWER).
  *
- * The power changes immediately each time a different movement function
- * is called as gradual changes were proving to be very difficult to work with.
+ * The movement functions only set the power and direction each motor should
+ * get to (target, targetDirection) and return straight away. motorRamp() is
+ * run by the scheduler every 1ms and moves the power towards the target by
+ * cal.slew % each time. To change direction the power is run down to 0
+ * first, and the direction is changed there. The tracks slip less than when
+ * the power jumped straight to the new value, and a movement takes the same
+ * time to get up to speed every time.
  *
  *
  *
@@ -44,156 +53,200 @@ void initPWM(void) {
 void initMotor(void) {
     motorL.power = 0; //zero power to start
     motorL.direction = 0; //set default motor direction
+    motorL.target = 0;
+    motorL.targetDirection = 0;
+    motorL.trim = 0;
     motorL.dutyLowByte = (unsigned char *) (&PDC0L); //store address of PWM duty low byte
     motorL.dutyHighByte = (unsigned char *) (&PDC0H); //store address of PWM duty high byte
     motorL.dir_pin = 0; //pin RB0/PWM0 controls direction
-    motorL.PWMperiod = 200; //store PWMperiod for motor
+    motorL.PWMperiod = PWM_PERIOD; //store PWMperiod for motor
 
     motorR.power = 0; //zero power to start
     motorR.direction = 0; //set default motor direction
+    motorR.target = 0;
+    motorR.targetDirection = 0;
+    motorR.trim = 0;
     motorR.dutyLowByte = (unsigned char *) (&PDC1L); //store address of PWM duty low byte
     motorR.dutyHighByte = (unsigned char *) (&PDC1H); //store address of PWM duty high byte
     motorR.dir_pin = 2; //pin RB2/PWM0 controls direction
-    motorR.PWMperiod = 200; //store PWMperiod for motor
+    motorR.PWMperiod = PWM_PERIOD; //store PWMperiod for motor
 }                                                     
 
+/*
+ * PWM duty for each power (0-100%), worked out by the compiler for PWM_PERIOD
+ * and already split into the PDCxL/PDCxH bytes, so setMotorPWM() needs no
+ * multiply or divide. In reverse the duty is PWM_PERIOD - duty, which is the
+ * entry for 100 - power.
+ */
+#define PWM_DUTY(p) ((unsigned int) (p) * PWM_PERIOD / 100)
+#define PWM_BYTES(p) {(unsigned char) (PWM_DUTY(p) << 2), (unsigned char) (PWM_DUTY(p) >> 6)}
+#define PWM_ROW(p) PWM_BYTES(p), PWM_BYTES(p + 1), PWM_BYTES(p + 2), PWM_BYTES(p + 3), \
+    PWM_BYTES(p + 4), PWM_BYTES(p + 5), PWM_BYTES(p + 6), PWM_BYTES(p + 7), \
+    PWM_BYTES(p + 8), PWM_BYTES(p + 9)
+
+static const unsigned char dutyTable[101][2] = {
+    PWM_ROW(0), PWM_ROW(10), PWM_ROW(20), PWM_ROW(30), PWM_ROW(40),
+    PWM_ROW(50), PWM_ROW(60), PWM_ROW(70), PWM_ROW(80), PWM_ROW(90),
+    PWM_BYTES(100)
+};
+
+//Function to add a trim to a power, keeping it within 0-100 (0 stays 0)
+static unsigned char trimPower(int power, signed char trim) {
+    if (power == 0) {
+        return 0;
+    }
+    power += trim;
+    if (power < 0) {
+        return 0;
+    }
+    if (power > 100) {
+        return 100;
+    }
+    return power;
+}
+
 //Function to set motor PWM from values in the motor structure
 void setMotorPWM(struct DC_motor *m) {
-    int PWMduty;
+    unsigned char p = trimPower(m->power, m->trim); // the speed regulator's trim (SPEED.c) on top
 
-    PWMduty = (m->power * m->PWMperiod) / 100;
+    PROF_BEGIN(PROF_MOTOR_PWM);
 
+    // the PWM output paired with the direction pin (PWM1, PWM3) is also off at
+    // its direction's level when overridden (OVDCONS, see SPEED.c)
     if (m->direction) {
-        PWMduty = m->PWMperiod - PWMduty;
+        p = 100 - p; // duty is the complement in reverse
+        OVDCONS = OVDCONS | (1 << (m->dir_pin + 1));
         LATB = LATB | (1 << (m->dir_pin));
     } else {
+        OVDCONS = OVDCONS & (~(1 << (m->dir_pin + 1)));
         LATB = LATB & (~(1 << (m->dir_pin)));
     }
 
-    *(m->dutyLowByte) = PWMduty << 2;
-    *(m->dutyHighByte) = PWMduty >> 6;
+    *(m->dutyLowByte) = dutyTable[p][0];
+    *(m->dutyHighByte) = dutyTable[p][1];
+
+    odomMotor(m); //dead reckoning follows every change of power
+    PROF_END(PROF_MOTOR_PWM);
 }                                     
 
-//Function to stop robot
-void Stop(struct DC_motor *m_L, struct DC_motor *m_R) {
-    for (m_L->power; (m_L->power) > 0; (m_L->power)--) { //increase motor power until 100
-        m_R->power = m_L->power;
-        setMotorPWM(m_L); //pass pointer to setMotorSpeed function (not &m here)
-        setMotorPWM(m_R);
-        
+struct DC_motor motorL, motorR; // the right and left motor
+uint16_t motorFirstTick = MOTOR_NOT_MOVED; // tick the motors were first given power
+
+//Function to move one motor a step towards its target
+static void rampMotor(struct DC_motor *m) {
+    unsigned char power = m->power;
+
+    if (m->direction != m->targetDirection) { // reversing: down to 0 first
+        if (power > cal.slew) {
+            power -= cal.slew;
+        } else if (power != 0) {
+            power = 0;
+        } else {
+            m->direction = m->targetDirection; // change direction at 0
+        }
+    } else if (power + cal.slew < m->target) {
+        power += cal.slew;
+    } else if (power > m->target + cal.slew) {
+        power -= cal.slew;
+    } else if (power != m->target) {
+        power = m->target;
+    } else {
+        return; // already there
     }
-}                    
-
-//Function to turn robot left
-void turnLeft(struct DC_motor *m_L, struct DC_motor *m_R) {
-    
-    m_L->direction = 1; // set direction of RIGHT motor
-    m_R->direction = 0; // set direction of LEFT motor
-
-
-    m_R->power = 72; // set power
-    m_L->power = 69; // set power
-    setMotorPWM(m_L); //pass pointer to setMotorSpeed function (not &m here)
-    setMotorPWM(m_R);
-
-}                
-
-//Function to turn robot right
-void turnRight(struct DC_motor *m_L, struct DC_motor *m_R) {
-    
-    m_L->direction = 0;
-    m_R->direction = 1;
-
-    m_R->power = 64; // set power
-    m_L->power = 69; // set power
-    setMotorPWM(m_R); //pass pointer to setMotorSpeed function (not &m here)
-    setMotorPWM(m_L);
-
-
-}               
-
-//Function to turn robot slightly right whilst maintaining forwards motion
-void turnSlightRight(struct DC_motor *m_L, struct DC_motor *m_R) {
-
-    m_L->direction = 0;
-    m_R->direction = 0;
-
-    m_R->power = 75;
-    m_L->power = 45;
-
-    setMotorPWM(m_R); //pass pointer to setMotorSpeed function (not &m here)
-    setMotorPWM(m_L);
-
-}     
-
-//Function to turn robot slightly right in a backwards direction
-void turnSlightRightBack(struct DC_motor *m_L, struct DC_motor *m_R) {
-
-    m_L->direction = 1;
-    m_R->direction = 1;
 
-    m_R->power = 70;
-    m_L->power = 85;
-    setMotorPWM(m_R); //pass pointer to setMotorSpeed function (not &m here)
-    setMotorPWM(m_L);
+    m->power = power;
+    setMotorPWM(m);
 
+    if (power != 0 && motorFirstTick == MOTOR_NOT_MOVED) { //for the boot time on the start screen
+        motorFirstTick = schedTicks();
+    }
+}
 
-}     
-
-//Function to turn robot slightly left in a backwards direction
-void turnSlightLeftBack(struct DC_motor *m_L, struct DC_motor *m_R) {
-
-    m_L->direction = 1;
-    m_R->direction = 1;
-
-
-    m_R->power = 90; // 70
-    m_L->power = 70; // 40
-    setMotorPWM(m_L); //pass pointer to setMotorSpeed function (not &m here)
-    setMotorPWM(m_R);
-
-
-}    
-
-//Function to turn robot slightly left whilst maintaining forwards motion
-void turnSlightLeft(struct DC_motor *m_L, struct DC_motor *m_R) {
-
-    m_L->direction = 0;
-    m_R->direction = 0;
-
-
-    m_R->power = 45;
-    m_L->power = 85;
-    setMotorPWM(m_L); //pass pointer to setMotorSpeed function (not &m here)
-    setMotorPWM(m_R);
-
-
-}         
-
-//Function for linear forward motion of robot
-void fullSpeedAhead(struct DC_motor *m_L, struct DC_motor *m_R) {
-    
-    m_L->direction = 0;
-    m_R->direction = 0;
-
-    m_L->power = 93; // 80 75 97 95 98
-    m_R->power = 95; // 90 85 99 97 95
-
-    setMotorPWM(m_L); //pass pointer to setMotorSpeed function (not &m here)
-    setMotorPWM(m_R);
-
-}          
+//Function to move both motors towards their targets, run every 1ms by the scheduler
+void motorRamp(void) {
+    rampMotor(&motorL);
+    rampMotor(&motorR);
+}
 
-//Function for linear reverse motion of robot
-void fullSpeedBack(struct DC_motor *m_L, struct DC_motor *m_R) {
-    
-    m_L->direction = 1;
-    m_R->direction = 1;
+/*
+ * Movements, indexed by MOVE_ID. Codes 1-8 are the 'reference codes' stored in
+ * the path log, and each movement names the one that undoes it, so the return
+ * can replay the log backwards. Retuning a movement, or adding one, is only a
+ * change to this table. The motor trims in the calibration (CAL.c) are
+ * applied on top, so one table suits every robot.
+ *
+ * MOTION_POWER(measured, matched) picks the right motor's power for the
+ * movements that should go straight or spin on the spot: the powers found to
+ * do so on the robot, or with the speed regulator (SPEED.c) the same as the
+ * left motor's.
+ */
+#if SPEED
+#define MOTION_POWER(measured, matched) (matched)
+#else
+#define MOTION_POWER(measured, matched) (measured)
+#endif
+
+const struct motion motions[MOVE_COUNT] = {
+    // right (m_L) power, direction, left (m_R) power, direction, inverse
+    {0, 0, 0, 0, MOVE_STOP}, // Stop
+    {45, 0, 75, 0, MOVE_SLIGHT_LEFT_BACK}, // turnSlightRight
+    {85, 0, 45, 0, MOVE_SLIGHT_RIGHT_BACK}, // turnSlightLeft
+    {MOTION_POWER(93, 95), 0, 95, 0, MOVE_BACK}, // fullSpeedAhead: right 80 75 97 95 98, left 90 85 99 97 95
+    {MOTION_POWER(69, 72), 1, 72, 0, MOVE_SPIN_RIGHT}, // turnLeft (clockwise, as m_L is the right motor)
+    {70, 1, 90, 1, MOVE_SLIGHT_RIGHT}, // turnSlightLeftBack: right 40, left 70 before
+    {85, 1, 70, 1, MOVE_SLIGHT_LEFT}, // turnSlightRightBack
+    {MOTION_POWER(98, 95), 1, 95, 1, MOVE_AHEAD}, // fullSpeedBack: right 78 98, left 75 95
+    {MOTION_POWER(69, 64), 0, 64, 1, MOVE_SPIN_LEFT}, // turnRight (anticlockwise)
+};
+
+//Function to start a movement from the table, the motors ramp to it (see motorRamp)
+void applyMotion(unsigned char id) {
+    const struct motion *mv = &motions[id];
+
+    motorL.target = trimPower(mv->rightPower, cal.rightTrim);
+    motorL.targetDirection = mv->rightDirection;
+    motorR.target = trimPower(mv->leftPower, cal.leftTrim);
+    motorR.targetDirection = mv->leftDirection;
+}
+
+#if !RETURN_DIRECT
+
+//Function to start a movement with both powers scaled up until the faster motor is at 100%, returns that motor's table power
+unsigned char applyMotionFast(unsigned char id) {
+    const struct motion *mv = &motions[id];
+    unsigned char top = mv->rightPower > mv->leftPower ? mv->rightPower : mv->leftPower;
+
+    if (top == 0) {
+        applyMotion(id);
+        return 100;
+    }
+    // same ratio between the wheels, so the same track, top/100 as long to drive it
+    motorL.target = trimPower((unsigned int) mv->rightPower * 100 / top, cal.rightTrim);
+    motorL.targetDirection = mv->rightDirection;
+    motorR.target = trimPower((unsigned int) mv->leftPower * 100 / top, cal.leftTrim);
+    motorR.targetDirection = mv->leftDirection;
+    return top;
+}
+
+#endif
+
+//Function for forward motion of robot, turning by a continuous amount (% power, right positive)
+void steerAhead(struct DC_motor *m_L, struct DC_motor *m_R, signed char turn) {
+    int right = motions[MOVE_AHEAD].rightPower - turn; // about fullSpeedAhead, the left wheel faster to turn right
+    int left = motions[MOVE_AHEAD].leftPower + turn;
+
+    if (left > 100) { // keep the difference between the wheels when one is at full power
+        right -= left - 100;
+        left = 100;
+    } else if (right > 100) {
+        left -= right - 100;
+        right = 100;
+    }
 
-    m_L->power = 98; //78 98
-    m_R->power = 95; //75 95
+    m_L->targetDirection = 0;
+    m_R->targetDirection = 0;
 
-    setMotorPWM(m_L); //pass pointer to setMotorSpeed function (not &m here)
-    setMotorPWM(m_R);
+    m_L->target = trimPower(right, cal.rightTrim);
+    m_R->target = trimPower(left, cal.leftTrim);
 
-}           
+}
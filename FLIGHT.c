@@ -0,0 +1,221 @@
+#include <xc.h>
+#include "HEADER.h"
+
+/*
+ * Flight recorder. The last FLIGHT_EVENTS events of the run are kept in a RAM
+ * ring, 6 bytes each:
+ *
+ *   ticks (2, low byte first) | type | CAP1 high byte | CAP2 high byte |
+ *   movement << 4 | mission
+ *
+ * For FLIGHT_BOOT the CAP1 byte is the reset cause instead.
+ *
+ * flightCommit() copies the ring to the data EEPROM, so it is still there
+ * after the robot is switched off. It is called when the mission ends, when
+ * an RFID frame fails, and after a brown-out: the ring is 'persistent' (not
+ * cleared by the start-up code), so after a brown-out reset the log of the
+ * run that failed is still in RAM, and is committed before anything else.
+ *
+ * There are two slots in the EEPROM and each commit goes in the one not
+ * holding the latest log, so a commit cut short by a power cut leaves the
+ * previous one intact, and each slot takes half the wear. Bytes that already
+ * hold the right value are not written again. A slot is:
+ *
+ *   events, oldest first (FLIGHT_EVENTS * 6) | count | reason | sequence |
+ *   check
+ *
+ * where the check makes all its bytes add up to 0 (an erased slot does not).
+ *
+ * Nothing waits for the EEPROM: flightStep() writes the next byte whenever
+ * the last write (about 4ms) has finished. Until the commit is done the ring
+ * is not changed, and events are counted in flightMissed instead.
+ *
+ * The latest log is sent as TELEM_FLIGHT records after every reset, and when
+ * FLIGHT_DUMP_BYTE is received on the serial line (see rfidPoll). The host
+ * decoder (sim/telemcsv.c) prints it as a timeline.
+ */
+
+#define FLIGHT_LOG_BYTES (FLIGHT_EVENTS * FLIGHT_EVENT_BYTES)
+#define FLIGHT_SLOT_BYTES (FLIGHT_LOG_BYTES + 4)
+#define FLIGHT_MAGIC 0x5A
+#define FLIGHT_NONE 0xFF // no slot / not committing / not dumping
+
+persistent unsigned char flightLog[FLIGHT_LOG_BYTES]; // the ring, kept through a brown-out reset
+persistent unsigned char flightHead; // events recorded (wraps), the next goes at flightHead % FLIGHT_EVENTS
+persistent unsigned char flightValid; // FLIGHT_MAGIC ^ flightHead while the ring holds a run
+unsigned char flightMissed = 0; // events not recorded while a commit was going on (stops at 255)
+
+static unsigned char flightLatest = FLIGHT_NONE; // slot holding the latest log
+static unsigned char flightSeq = 0; // its sequence number
+static unsigned char commitSlot = FLIGHT_NONE; // slot being written
+static unsigned char commitPos; // next byte of it
+static unsigned char commitImage[4]; // count, reason, sequence, check
+static unsigned char commitStart; // ring byte of the oldest event
+static unsigned char dumpPart = FLIGHT_NONE; // next part of the latest log to send
+
+//Function to give the EEPROM address of a slot
+static unsigned char flightSlotAddress(unsigned char slot) {
+    return FLIGHT_ADDRESS + (slot ? FLIGHT_SLOT_BYTES : 0);
+}
+
+//Function to check a slot holds a log
+static char flightSlotValid(unsigned char slot) {
+    unsigned char address = flightSlotAddress(slot);
+    unsigned char sum = 0;
+
+    for (unsigned char i = 0; i < FLIGHT_SLOT_BYTES; i++) {
+        sum += eeRead(address + i);
+    }
+    return sum == 0 && eeRead(address + FLIGHT_LOG_BYTES) <= FLIGHT_EVENTS;
+}
+
+//Function to give byte i of the slot being committed
+static unsigned char flightImage(unsigned char i) {
+    unsigned char j;
+
+    if (i >= FLIGHT_LOG_BYTES) {
+        return commitImage[i - FLIGHT_LOG_BYTES];
+    }
+    j = commitStart + i; //the ring, oldest event first
+    if (j >= FLIGHT_LOG_BYTES) {
+        j -= FLIGHT_LOG_BYTES;
+    }
+    return flightLog[j];
+}
+
+//Function to find the latest log in the EEPROM and keep (or clear) the ring, call once at start-up
+void flightInit(void) {
+    unsigned char cause = FLIGHT_RESET_OTHER;
+    unsigned char seq;
+
+    if (!RCONbits.POR) {
+        cause = FLIGHT_RESET_POWER;
+    } else if (!RCONbits.BOR) {
+        cause = FLIGHT_RESET_BROWNOUT;
+    }
+    RCONbits.POR = 1; // so the next reset can be told apart
+    RCONbits.BOR = 1;
+
+    for (unsigned char slot = 0; slot < 2; slot++) {
+        if (flightSlotValid(slot)) {
+            seq = eeRead(flightSlotAddress(slot) + FLIGHT_LOG_BYTES + 2);
+            if (flightLatest == FLIGHT_NONE || (signed char) (seq - flightSeq) > 0) {
+                flightLatest = slot;
+                flightSeq = seq;
+            }
+        }
+    }
+
+    if (cause == FLIGHT_RESET_BROWNOUT && flightValid == (FLIGHT_MAGIC ^ flightHead)) {
+        flightCommit(FLIGHT_COMMIT_BROWNOUT); // the run that failed
+    } else {
+        flightHead = 0;
+        for (unsigned int i = 0; i < FLIGHT_LOG_BYTES; i++) {
+            flightLog[i] = 0;
+        }
+    }
+    flightValid = FLIGHT_MAGIC ^ flightHead;
+
+    flightDump(); // the latest log goes out with the first telemetry
+    flightRecord(FLIGHT_BOOT, cause, 0, 0, 0);
+}
+
+//Function to add an event to the ring
+void flightRecord(unsigned char type, unsigned char cap1, unsigned char cap2, unsigned char move, unsigned char mission) {
+    unsigned char *e;
+    uint16_t ticks = schedTicks();
+
+    if (commitSlot != FLIGHT_NONE) { // being copied to the EEPROM
+        if (flightMissed != 255) {
+            flightMissed++;
+        }
+        return;
+    }
+
+    e = &flightLog[(flightHead & (FLIGHT_EVENTS - 1)) * FLIGHT_EVENT_BYTES];
+    e[0] = ticks;
+    e[1] = ticks >> 8;
+    e[2] = type;
+    e[3] = cap1;
+    e[4] = cap2;
+    e[5] = move << 4 | (mission & 0x0F);
+    flightHead++;
+    flightValid = FLIGHT_MAGIC ^ flightHead;
+}
+
+//Function to start copying the ring to the EEPROM (ignored if a commit is already going on)
+void flightCommit(unsigned char reason) {
+    unsigned char sum = 0;
+
+    if (commitSlot != FLIGHT_NONE) {
+        return;
+    }
+    commitSlot = flightLatest == 0 ? 1 : 0; // not the latest log
+    commitPos = 0;
+    commitStart = (flightHead & (FLIGHT_EVENTS - 1)) * FLIGHT_EVENT_BYTES; // the oldest is next to be overwritten
+
+    commitImage[0] = flightHead < FLIGHT_EVENTS ? flightHead : FLIGHT_EVENTS;
+    commitImage[1] = reason;
+    commitImage[2] = flightSeq + 1;
+    commitImage[3] = 0;
+    for (unsigned char i = 0; i < FLIGHT_SLOT_BYTES; i++) {
+        sum += flightImage(i);
+    }
+    commitImage[3] = -sum;
+}
+
+//Function to carry on a commit, run every 1ms. Writes the next byte that needs it once the last write is done
+void flightStep(void) {
+    unsigned char address, data;
+
+    if (commitSlot == FLIGHT_NONE || eeBusy()) {
+        return;
+    }
+
+    address = flightSlotAddress(commitSlot);
+    while (commitPos < FLIGHT_SLOT_BYTES) {
+        data = flightImage(commitPos);
+        if (eeRead(address + commitPos) != data) { // unchanged bytes are not written again
+            eeWriteStart(address + commitPos++, data);
+            return;
+        }
+        commitPos++;
+    }
+
+    // all written (the check byte last)
+    flightLatest = commitSlot;
+    flightSeq = commitImage[2];
+    commitSlot = FLIGHT_NONE;
+}
+
+//Function to check whether a commit is still being written
+char flightSaving(void) {
+    return commitSlot != FLIGHT_NONE;
+}
+
+//Function to send the latest log with the telemetry (from the start)
+void flightDump(void) {
+    dumpPart = flightLatest == FLIGHT_NONE ? FLIGHT_NONE : 0;
+}
+
+//Function to queue the next part of a dump, returns 0 if there is nothing to send now
+char flightDumpNext(void) {
+    unsigned char part[FLIGHT_PART_EVENTS * FLIGHT_EVENT_BYTES];
+    unsigned char address;
+
+    if (dumpPart == FLIGHT_NONE || commitSlot != FLIGHT_NONE || eeBusy()) { // nothing to send, the slots are changing, or CAL is writing
+        return 0;
+    }
+    address = flightSlotAddress(flightLatest);
+    for (unsigned char i = 0; i < sizeof (part); i++) {
+        part[i] = eeRead(address + dumpPart * sizeof (part) + i);
+    }
+    if (telemFlight(dumpPart, eeRead(address + FLIGHT_LOG_BYTES), eeRead(address + FLIGHT_LOG_BYTES + 1),
+            flightSeq, part)) {
+        dumpPart++;
+        if (dumpPart == FLIGHT_EVENTS / FLIGHT_PART_EVENTS) {
+            dumpPart = FLIGHT_NONE;
+        }
+    }
+    return 1;
+}
@@ -0,0 +1,71 @@
+#include <xc.h>
+#include "HEADER.h"
+
+/*
+ * Fixed width number formatting, used instead of sprintf for the LCD.
+ *
+ * Each function writes exactly 'width' characters into the caller's buffer
+ * (no terminating 0) and returns a pointer just past them, so calls can be
+ * chained. Decimal digits are found by subtracting powers of ten, as the PIC
+ * has no divide instruction. A number too wide for its field is shown as
+ * '#' characters rather than cut short.
+ */
+
+static const unsigned int fmtPowers[5] = {10000, 1000, 100, 10, 1};
+
+//Function to find the decimal digits of a number, returns how many there are (leading zeros not counted, at least 1)
+static unsigned char fmtDigits(char *digits, unsigned int value) {
+    unsigned char i, count = 0;
+    char digit;
+
+    for (i = 0; i < 5; i++) {
+        digit = '0';
+        while (value >= fmtPowers[i]) {
+            value -= fmtPowers[i];
+            digit++;
+        }
+        if (digit != '0' || count != 0 || i == 4) {
+            digits[count++] = digit;
+        }
+    }
+    return count;
+}
+
+//Function to fill a field with a number's digits, right aligned
+static char *fmtField(char *out, char *digits, unsigned char count, unsigned char width) {
+    unsigned char i;
+
+    if (count > width) { //does not fit
+        for (i = 0; i < width; i++) {
+            *out++ = '#';
+        }
+        return out;
+    }
+    for (i = count; i < width; i++) {
+        *out++ = ' ';
+    }
+    for (i = 0; i < count; i++) {
+        *out++ = digits[i];
+    }
+    return out;
+}
+
+//Function to write an unsigned number, right aligned in width characters
+char *fmtUnsigned(char *out, unsigned int value, unsigned char width) {
+    char digits[5];
+
+    return fmtField(out, digits, fmtDigits(digits, value), width);
+}
+
+//Function to write the low width hex digits of a number, with leading zeros
+char *fmtHex(char *out, unsigned int value, unsigned char width) {
+    static const char hex[] = "0123456789ABCDEF";
+    unsigned char i = width;
+
+    while (i != 0) {
+        i--;
+        out[i] = hex[value & 0x0F];
+        value >>= 4;
+    }
+    return out + width;
+}
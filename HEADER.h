@@ -3,6 +3,23 @@
 
 #define _XTAL_FREQ 8000000
 #include <xc.h>
+#include <stdint.h>
+
+#ifndef PROFILE
+#define PROFILE 0 // profiler (PROF), 1 for a diagnostic build: its RAM does not fit alongside the rest
+#endif
+
+#ifndef TRACE
+#define TRACE 0 // trace capture (TRACE), 1 sends the IR and RFID input instead of the state records
+#endif
+
+#ifndef RETURN_DIRECT
+#define RETURN_DIRECT 1 // straight home by dead reckoning (ODOM), 0 replays the path log (PATH) backwards
+#endif
+
+#ifndef SPEED
+#define SPEED 1 // wheel speed regulation (SPEED) to cal.emfFull, 0 drives the measured table powers open loop
+#endif
 
 
 /*----------------------------------------------------------------------------
@@ -16,6 +33,34 @@
  *
  * SERIAL -- Configures serial communication for RFID
  *
+ * RFID -- Assembles and checks RFID frames from the serial data
+ *
+ * SCHED -- Runs the program's tasks from the 1ms Timer2 tick
+ *
+ * PATH -- Run-length log of the movements, replayed backwards on the return
+ *
+ * ODOM -- Dead reckoning of the robot's position from the motor powers
+ *
+ * IR -- Filters the IR receiver pulse widths from the input capture interrupt
+ *
+ * STEER -- PID controller steering towards the beacon from the IR readings
+ *
+ * SEARCH -- Sweeps for the beacon, turning back to the strongest IR signal
+ *
+ * CAL -- Calibration block kept in the data EEPROM
+ *
+ * TELEM -- Binary telemetry records sent on the EUSART transmitter
+ *
+ * FMT -- Fixed width number formatting (instead of sprintf)
+ *
+ * PROF -- Cycle timing of the hot paths and the mission, from Timer1
+ *
+ * FLIGHT -- Flight recorder of the last events, saved to the data EEPROM
+ *
+ * TRACE -- Timestamped IR captures and RFID bytes, for replay on a PC
+ *
+ * SPEED -- Holds the wheels at matched speeds from their back-EMF (ADC)
+ *
  * SETUP -- General set-up functions and other functions of robot
  -----------------------------------------------------------------------------*/
 
@@ -25,33 +70,62 @@
  DC MOTOR
  -----------------------------------------------------------------------------*/
 
+#define PWM_PERIOD 200          // PWM period (PTPER + 1), setMotorPWM's duty table is built for it
+#define MOTOR_SLEW 2            // default % power the motors change by each 1ms
+
+// movements in the motion table, 1-8 are the path log 'reference codes'
+#define MOVE_STOP 0
+#define MOVE_SLIGHT_RIGHT 1     // turnSlightRight
+#define MOVE_SLIGHT_LEFT 2      // turnSlightLeft
+#define MOVE_AHEAD 3            // fullSpeedAhead
+#define MOVE_SPIN_LEFT 4        // turnLeft
+#define MOVE_SLIGHT_LEFT_BACK 5 // turnSlightLeftBack
+#define MOVE_SLIGHT_RIGHT_BACK 6 // turnSlightRightBack
+#define MOVE_BACK 7             // fullSpeedBack
+#define MOVE_SPIN_RIGHT 8       // turnRight
+#define MOVE_COUNT 9
+
 //definition of DC_motor structure
 struct DC_motor {
     char power;                             //motor power, out of 100
     char direction;                         //motor direction, forward(1), reverse(0)
+    char target;                            //power motorRamp() is moving towards
+    char targetDirection;                   //direction motorRamp() is moving towards
+    signed char trim;                       //% power added by the speed regulator (SPEED)
     unsigned char *dutyLowByte;             //PWM duty low byte address
     unsigned char *dutyHighByte;            //PWM duty high byte address
     char dir_pin;                           // pin that controls direction on PORTB
-    int PWMperiod;                          //base period of PWM cycle
+    int PWMperiod;                          //base period of PWM cycle (PWM_PERIOD)
 };
 
-struct DC_motor motorL, motorR; //declare two DC_motor structures
+extern struct DC_motor motorL, motorR; //the two DC_motor structures (DCMOTOR.c)
+
+#define MOTOR_NOT_MOVED 0xFFFF
+extern uint16_t motorFirstTick; // tick the motors were first given power, MOTOR_NOT_MOVED until then
+
+//definition of a movement in the motion table
+struct motion {
+    unsigned char rightPower;               //m_L power
+    unsigned char rightDirection;           //m_L direction, reverse(1)
+    unsigned char leftPower;                //m_R power
+    unsigned char leftDirection;            //m_R direction, reverse(1)
+    unsigned char inverse;                  //movement that undoes this one
+};
+
+extern const struct motion motions[MOVE_COUNT];
 
 
 //Function prototypes
 void initPWM();                                                     //Function to setup PWM
 void initMotor(void);                                               //Function to set up motor structures
 void setMotorPWM(struct DC_motor *m);                               //Function to set motor PWM from values in the motor structure
+void motorRamp(void);                                               //Function to move both motors towards their targets (every 1ms)
 
-void Stop(struct DC_motor *mL, struct DC_motor *mR);                //Function to stop robot
-void turnLeft(struct DC_motor *mL, struct DC_motor *mR);            //Function to turn robot left
-void turnRight(struct DC_motor *mL, struct DC_motor *mR);           //Function to turn robot right
-void turnSlightRight(struct DC_motor *mL, struct DC_motor *mR);     //Function to turn robot slightly right whilst maintaining forwards motion
-void turnSlightLeft(struct DC_motor *mL, struct DC_motor *mR);      //Function to turn robot slightly left whilst maintaining forwards motion
-void turnSlightRightBack(struct DC_motor *mL, struct DC_motor *mR); //Function to turn robot slightly right in a backwards direction
-void turnSlightLeftBack(struct DC_motor *mL, struct DC_motor *mR);  //Function to turn robot slightly left in a backwards direction
-void fullSpeedAhead(struct DC_motor *mL, struct DC_motor *mR);      //Function for linear forward motion of robot
-void fullSpeedBack(struct DC_motor *mL, struct DC_motor *mR);       //Function for linear reverse motion of robot
+void applyMotion(unsigned char id);                                 //Function to start a movement from the motion table
+void steerAhead(struct DC_motor *mL, struct DC_motor *mR, signed char turn); //Function for forward motion, turning by a continuous amount
+#if !RETURN_DIRECT
+unsigned char applyMotionFast(unsigned char id);                    //Function to start a movement scaled up to full power, returns the table power it was scaled from
+#endif
 
 /*----------------------------------------------------------------------------
  LCD
@@ -66,10 +140,19 @@ void LCDout(unsigned char number);
 //function to send data/commands over a 4bit interface
 void SendLCD(unsigned char Byte, char type);
 
+//writes one character at the cursor (into the framebuffer)
+void LCD_Char(char c);
+
 //turns characters into a string
 void LCD_String(char *string);
 
-//Initialise LCD
+//writes an unsigned number at the cursor, right aligned in width characters
+void LCD_Unsigned(unsigned int value, unsigned char width);
+
+//writes the low width hex digits of a number at the cursor, with leading zeros
+void LCD_Hex(unsigned int value, unsigned char width);
+
+//Initialise LCD (the sequence is sent in the background by LCD_Flush)
 void LCD_Init(void);
 
 //function to put cursor to start of line
@@ -81,6 +164,9 @@ void clearLCD(void);
 //function to send certain custom characters to the LCD (for checksum, etc)
 void customChars(void);
 
+//sends the next changed byte to the LCD, run every 1ms by the scheduler
+void LCD_Flush(void);
+
 /*----------------------------------------------------------------------------
  LED
  -----------------------------------------------------------------------------*/
@@ -92,12 +178,532 @@ void LEDout(int number );
  SERIAL
  -----------------------------------------------------------------------------*/
 
-//Wait for byte to be received and return received byte
-char getCharSerial(void);
+#define RX_BUFFER_SIZE 16   // receive ring buffer size, must be a power of 2 (the sensing task empties it every 5ms, about 5 bytes at 9600 baud)
+
+extern volatile unsigned char rxBuffer[RX_BUFFER_SIZE];   // bytes received by RFIDinterrupt()
+extern volatile unsigned char rxHead;                     // next free slot, written by the ISR only
+extern volatile unsigned char rxTail;                     // next unread byte, written by readSerial() only
+extern volatile unsigned char rxDropped;                  // bytes lost because the buffer was full
+
+#define TX_BUFFER_SIZE 64   // transmit ring buffer size, must be a power of 2
+
+extern volatile unsigned char txBuffer[TX_BUFFER_SIZE];   // bytes waiting to be sent by the low priority interrupt
+extern volatile unsigned char txHead;                     // next free slot, written by writeSerial() only
+extern volatile unsigned char txTail;                     // next byte to send, written by the ISR only
+
+//Take the next received byte out of the ring buffer, returns 0 if there is none
+char readSerial(unsigned char *byte);
+
+//Queue bytes for sending, returns 0 if there is not room for all of them (never waits)
+char writeSerial(const unsigned char *data, unsigned char len);
 
 //function to set up EUSART registers
 void setupEUSART(void);
 
+/*----------------------------------------------------------------------------
+ RFID
+ -----------------------------------------------------------------------------*/
+
+#define RFID_FRAME_LENGTH 16    // 0x02, 10 data, 2 checksum, CR, LF, 0x03
+#define RFID_TIMEOUT_TICKS 20   // ms with no new byte before a partial frame is dropped, or commands are taken again after one
+#define RFID_TAG_BYTES 5        // the 10 data digits as bytes
+#define RFID_VOTES 2            // valid frames in a row that must agree before a tag counts
+
+#define RFID_NONE 0             // no complete frame yet (or not enough agreeing ones)
+#define RFID_OK 1               // tag confirmed, its bytes are in rfidTag
+#define RFID_ERROR 2            // frame failed checksum, was badly formed or timed out
+
+extern char rfidData[RFID_FRAME_LENGTH]; // Holds data from RFID
+extern unsigned char rfidTag[RFID_TAG_BYTES]; // tag as bytes, confirmed when rfidPoll() returns RFID_OK
+
+//Assemble RFID frames from the received bytes, call regularly from the main loop
+char rfidPoll(void);
+
+/*----------------------------------------------------------------------------
+ SCHED
+ -----------------------------------------------------------------------------*/
+
+#define SCHED_TICK_CYCLES 2000U // instruction cycles (Timer1 counts) in a 1ms tick
+
+//definition of a task slot
+struct task {
+    void (*run)(void);                      //task function, NULL for an unused slot
+    unsigned char period;                   //ticks between runs
+    unsigned char deadline;                 //ticks late before a run counts as an overrun
+    uint16_t due;                           //tick the task next runs at
+    unsigned char overruns;                 //runs started later than the deadline (stops at 255)
+};
+
+/* Ticks are 16 bits (uint16_t, on the host too) and wrap every 65.5s, so a
+ * time is only ever compared as the difference from another one, cast back
+ * to 16 bits: (uint16_t) (schedTicks() - then) is right across the wrap for
+ * anything shorter than that. */
+extern volatile uint16_t sysTicks;          // 1ms ticks, counted by the Timer2 interrupt
+extern uint16_t bootTick;                   // sysTicks at reset, what the times since reset count from (set by main)
+
+//Read sysTicks safely from the main program
+uint16_t schedTicks(void);
+
+//Run the tasks in the table forever, call once everything is set up
+void schedRun(struct task *tasks, unsigned char count);
+
+
+/*----------------------------------------------------------------------------
+ PATH
+ -----------------------------------------------------------------------------*/
+
+#if !RETURN_DIRECT // only the replay needs the log
+
+#define PATH_CAPACITY 64        // segments in the path log (2 bytes each)
+#define PATH_SCALE_MAX 10       // coarsest unit is 2^10 ticks
+
+extern unsigned char pathScale; // a unit in the log is 2^pathScale ticks, goes up when the log fills
+extern unsigned char pathLength; // segments in the log
+
+//Record ticks driven of a movement ('reference code' 1-8)
+void pathAdd(char code, unsigned char ticks);
+
+//Finish recording and start reading the log backwards
+void pathRewind(void);
+
+//Read the log backwards a segment at a time, returns the 'reference code' (and its ticks) or 0 at the start
+char pathPrev(unsigned int *ticks);
+
+#endif
+
+
+/*----------------------------------------------------------------------------
+ ODOM
+ -----------------------------------------------------------------------------*/
+
+#define ODOM_UM_PER_PCT 3       // um a wheel moves in 1ms for each % of power (300mm/s at 100%)
+#define ODOM_TRACK_UM 150000L   // um between the middles of the two tracks
+#define ODOM_DEADBAND 10        // % power below which the wheels do not turn
+
+#define ODOM_ANGLE(deg) ((uint32_t) (deg) * 11930465UL) // degrees to binary angle
+
+extern int32_t odomX, odomY;        // um from the start, x along the starting heading
+extern uint32_t odomHeading;        // binary angle (2^32 is one turn), anticlockwise from the start
+extern int32_t odomTravel;          // um driven along the heading
+
+//Note the power a motor has just been set to (called by setMotorPWM)
+void odomMotor(struct DC_motor *m);
+
+//Move the pose on by a number of 1ms ticks
+void odomStep(unsigned char ticks);
+
+//Heading and distance (um) from the robot back to the start
+void odomHome(uint32_t *bearing, int32_t *distance);
+
+
+/*----------------------------------------------------------------------------
+ IR
+ -----------------------------------------------------------------------------*/
+
+#define IR_EMA_SHIFT 1          // moving average weight of a new reading is 1/2^IR_EMA_SHIFT
+#define IR_STALE_TICKS 200      // ms after which a reading is out of date (beacon pulses every ~50ms)
+
+//filter state of one IR receiver, kept by the interrupt
+struct ir_channel {
+    unsigned int history[2];                //last two raw pulse widths, for the median
+    unsigned int value;                     //filtered pulse width (16 bit CAPxBUF)
+    unsigned char samples;                  //readings so far (wraps)
+    uint16_t stamp;                         //sysTicks of the last reading
+    char seen;                              //1 once there has been a reading
+};
+
+//reading of one IR receiver, published by the interrupt for the main program
+struct ir_reading {
+    unsigned int value;
+    unsigned char samples;
+    uint16_t stamp;
+    char seen;
+};
+
+//Filter a new pulse width (from the low priority interrupt)
+void irSample(unsigned char ch, unsigned int raw);
+
+//Copy the latest readings of both channels, from the same moment (interrupts stay on)
+void irSnapshot(struct ir_reading *cap1, struct ir_reading *cap2);
+
+//Check a reading is recent enough to steer by
+char irFresh(struct ir_reading *r);
+
+
+/*----------------------------------------------------------------------------
+ STEER
+ -----------------------------------------------------------------------------*/
+
+#define STEER_ERROR_SHIFT 4     // error is the IR difference in 16ths of a CAPxBUF count
+#define STEER_KP 64             // default gains (see CAL), in 256ths of % power per unit of error
+#define STEER_KI 2
+#define STEER_KD 32
+#define STEER_SUM_MAX 2560      // sum of errors is clamped to this (Ki of 2 gives 20%)
+#define STEER_TURN_MAX 30       // largest turn, % power
+#define STEER_STRAIGHT 8        // smaller turns are recorded in the path log as fullSpeedAhead
+
+//Forget the controller's history
+void steerReset(void);
+
+//Work out the turn (% power, right positive) from the two IR readings
+signed char steerUpdate(unsigned int cap1, unsigned int cap2);
+
+
+/*----------------------------------------------------------------------------
+ SEARCH
+ -----------------------------------------------------------------------------*/
+
+#define SEARCH_SHORT 45         // degrees swept each side at first after losing the beacon (doubles each time)
+#define SEARCH_AIM_DEG 3        // facing the strongest signal when within this many degrees of it
+#define SEARCH_PEAK_MIN (16U << 8) // weaker peaks are not the beacon (strength is CAP1/2 + CAP2/2)
+#define SEARCH_PEAK_DROP 192    // past the peak once the strength is down to 192/256 of it
+
+//Note the beacon is being tracked at the present heading
+void searchSeen(void);
+
+//Start a sweep (side is the last steering turn, right positive), returns the movement to drive
+unsigned char searchStart(signed char side);
+
+//Carry on the sweep, returns the movement to drive, MOVE_STOP when facing the strongest signal
+unsigned char searchUpdate(unsigned int cap1, unsigned int cap2, char fresh);
+
+
+/*----------------------------------------------------------------------------
+ CAL
+ -----------------------------------------------------------------------------*/
+
+#define CAL_ADDRESS 0x00        // where the block is kept in the data EEPROM
+#define CAL_VERSION 3           // change when the layout of the block changes
+#define CAL_BYTES 23            // the block as kept in the data EEPROM, CRC-16 last (see CAL.c)
+#define CAL_WRITE_BYTE 'W'      // received on the serial line outside an RFID frame (never hex, 0x02, 0x03, CR or LF), followed by a block to use and save
+
+// compiled defaults, used when the EEPROM has no valid block
+#define CAL_IR_AHEAD_LOW (195U << 8)        // beacon directly ahead when both IR readings are in here
+#define CAL_IR_AHEAD_HIGH ((196U << 8) - 1) // (195 in the high byte, found by experiment)
+#define CAL_IR_LOST_CAP1 (1U << 8)          // signal lost below both of these
+#define CAL_IR_LOST_CAP2 (6U << 8)          // (high bytes 0 and 5 or less)
+#define CAL_SPBRG 205           // 9600 baud (207 in theory, 205 measured)
+#define CAL_EMF_FULL 800        // back-EMF reading (ADC counts) of a motor at full speed (SPEED), not measured on the robot yet
+
+// a block with anything outside these is not used
+#define CAL_TRIM_MAX 20         // motor trims, either way
+#define CAL_SPBRG_MIN 197       // baud rate within 5% of 9600
+#define CAL_SPBRG_MAX 217
+#define CAL_SLEW_MIN 1          // 0 would never move the motors
+#define CAL_SLEW_MAX 20
+#define CAL_GAIN_MAX 1024       // steering gains, 0 to 4% power per unit of error
+#define CAL_EMF_FULL_MIN 100    // full speed back-EMF, ADC counts
+#define CAL_EMF_FULL_MAX 1000   // (1023 is the diode clamp, not a speed)
+                                // (and the IR signal-lost thresholds must be below the ahead ones)
+
+// calibration reports (TELEM_CAL)
+#define CAL_DEFAULTS 0          // no valid block in the EEPROM, the defaults are in use
+#define CAL_LOADED 1            // the block from the EEPROM is in use
+#define CAL_WRITTEN 2           // a block from the serial line is in use, and is being saved
+#define CAL_REJECTED 3          // a block from the serial line was damaged or out of range, nothing changed
+
+//definition of the calibration block
+struct calibration {
+    unsigned char version;                  //CAL_VERSION
+    signed char rightTrim;                  //% added to every right (m_L) motor power
+    signed char leftTrim;                   //% added to every left (m_R) motor power
+    unsigned int irAheadLow;                //IR readings with the beacon directly ahead
+    unsigned int irAheadHigh;
+    unsigned int irLostCap1;                //signal lost when CAP1 and CAP2 are both below these
+    unsigned int irLostCap2;
+    unsigned char spbrg;                    //EUSART baud rate
+    unsigned char slew;                     //% power the motors change by each 1ms
+    int kp, ki, kd;                         //steering gains, 256ths
+    unsigned int emfFull;                   //back-EMF reading of a motor at full speed, ADC counts (SPEED)
+};
+
+extern struct calibration cal;
+
+//Set the block to the compiled defaults
+void calDefaults(void);
+
+//Load the block from the EEPROM, returns 0 if it was not valid (defaults used)
+char calLoad(void);
+
+//Start taking a block from the serial line (CAL_WRITE_BYTE received)
+void calWriteStart(void);
+
+//Take a byte of a block from the serial line, returns 0 if it is not part of one (called by rfidPoll)
+char calReceive(unsigned char byte);
+
+//Drop a block that stopped coming and carry on saving the last one, run every 1ms by the scheduler
+void calStep(void);
+
+//Check whether a block is still being saved
+char calSaving(void);
+
+//Queue the calibration report if one is waiting, returns 0 if there is nothing to send (called by telemTask)
+char calReportNext(void);
+
+//Read one byte of the data EEPROM
+unsigned char eeRead(unsigned char address);
+
+//Check whether a data EEPROM write is still going on
+char eeBusy(void);
+
+//Start writing one byte of the data EEPROM (only once eeBusy() is 0), returns straight away
+void eeWriteStart(unsigned char address, unsigned char data);
+
+
+/*----------------------------------------------------------------------------
+ TELEM
+ -----------------------------------------------------------------------------*/
+
+#define TELEM_TICKS 25          // ms between records (40 a second, 720 of the 960 bytes/s at 9600 baud)
+
+/* Frame: TELEM_SYNC, length, payload, checksum (all bytes after the sync add
+ * up to 0). Multi-byte values are sent low byte first. The host decoder is
+ * sim/telemcsv.c. */
+#define TELEM_SYNC 0xA5
+#define TELEM_STATE 1           // record type: state of the robot
+#define TELEM_STATE_LENGTH 15   // payload bytes of a TELEM_STATE record
+#define TELEM_PROFILE 2         // record type: one profiler probe (PROF), sent once the mission is done
+#define TELEM_PROFILE_LENGTH (13 + 2 * PROF_BINS)
+#define TELEM_MARKS 3           // record type: the mission marks (PROF)
+#define TELEM_MARKS_LENGTH 8
+#define TELEM_FLIGHT 4          // record type: part of the flight recorder log (FLIGHT)
+#define TELEM_FLIGHT_LENGTH (6 + FLIGHT_PART_EVENTS * FLIGHT_EVENT_BYTES)
+#define TELEM_TRACE 5           // record type: IR captures and RFID bytes (TRACE), 1 to TRACE_PART_EVENTS of them
+#define TELEM_TRACE_LENGTH(n) (3 + (n) * TRACE_EVENT_BYTES)
+#define TELEM_POWER 6           // record type: ticks and idle time of each mission phase (PROF)
+#define TELEM_POWER_LENGTH (2 + 4 * PROF_PHASES)
+#define TELEM_CAL 7             // record type: the calibration block in use (CAL), at start-up and after a write
+#define TELEM_CAL_LENGTH (3 + CAL_BYTES)
+
+//contents of a TELEM_STATE record
+struct telem_state {
+    uint16_t ticks;                         //schedTicks() when it was taken
+    unsigned int cap1, cap2;                //filtered IR readings
+    unsigned char move;                     //movement 'reference code' (moveCode)
+    signed char right, left;                //motor powers, negative in reverse
+    unsigned char pathRuns, pathScale;      //path log length and unit
+    unsigned char mission;                  //mission phase
+};
+
+extern unsigned char telemDropped;          // records not sent because the buffer was full (stops at 255)
+
+//Queue a state record, dropped (and counted) if the transmit buffer is full
+void telemState(struct telem_state *t);
+
+#if PROFILE
+//Queue a probe's results, returns 0 if it was dropped
+char telemProfile(unsigned char p);
+
+//Queue the mission marks, returns 0 if it was dropped
+char telemMarks(void);
+
+//Queue the ticks and idle time of each mission phase, returns 0 if it was dropped
+char telemPower(void);
+#endif
+
+//Queue part of a flight recorder log (FLIGHT_PART_EVENTS events), returns 0 if it was dropped
+char telemFlight(unsigned char part, unsigned char count, unsigned char reason, unsigned char seq, unsigned char *events);
+
+//Queue a calibration report (CAL_ status and the block), returns 0 if it was dropped
+char telemCal(unsigned char status, unsigned char *block);
+
+#if TRACE
+//Queue count trace events, returns 0 if they were dropped
+char telemTrace(unsigned char count, unsigned char *events);
+#endif
+
+
+/*----------------------------------------------------------------------------
+ FMT
+ -----------------------------------------------------------------------------*/
+
+// Each writes exactly width characters (no terminating 0) and returns a pointer past them.
+// Numbers too wide for the field are shown as '#'s.
+
+//Write an unsigned number, right aligned
+char *fmtUnsigned(char *out, unsigned int value, unsigned char width);
+
+//Write the low width hex digits of a number, with leading zeros
+char *fmtHex(char *out, unsigned int value, unsigned char width);
+
+
+/*----------------------------------------------------------------------------
+ PROF
+ -----------------------------------------------------------------------------*/
+
+#define PROF_BINS 12            // histogram bins, powers of 2 cycles (the last is 2048 cycles, 1ms, and up)
+
+// probes
+#define PROF_IR_ISR 0           // low priority interrupt (IR, tick, telemetry)
+#define PROF_RFID_ISR 1         // high priority interrupt (RFID bytes)
+#define PROF_MOTOR_PWM 2        // setMotorPWM
+#define PROF_STEER 3            // steering task
+#define PROF_TICK 4             // one pass of the task table
+#define PROF_PROBES 5
+
+// mission marks
+#define PROF_MARK_BEACON 0      // beacon first found
+#define PROF_MARK_RFID 1        // RFID read
+#define PROF_MARK_HOME 2        // back at the start
+#define PROF_MARKS 3
+
+// mission phases the idle time is added up in, one more than the marks reached
+#define PROF_PHASES (PROF_MARKS + 1) // to the beacon, to the RFID, the return, done
+
+//results of one probe, in instruction cycles (500ns)
+struct prof_probe {
+    unsigned int start;                     //Timer1 at PROF_BEGIN
+    unsigned int min, max;                  //shortest and longest run
+    uint32_t total;                         //all runs added up
+    unsigned int count;                     //runs (stops at 65535)
+    unsigned int hist[PROF_BINS];           //runs of 2^n to 2^(n+1)-1 cycles (stop at 65535)
+};
+
+//Read Timer1 (free running, 1 count per instruction cycle)
+unsigned int profTimer(void);
+
+#if PROFILE
+
+extern struct prof_probe prof[PROF_PROBES];
+extern uint16_t profMarks[PROF_MARKS];      // ticks since reset each mark was reached at, 0 if not yet
+extern uint32_t profIdleCycles[PROF_PHASES]; // cycles the CPU idled in each phase
+extern unsigned int profPhaseTicks[PROF_PHASES]; // ticks in each phase (stop at 65535)
+
+#define PROF_BEGIN(p) (prof[p].start = profTimer())
+#define PROF_END(p) profEnd(p, prof[p].start)
+#define PROF_MARK(m) profMark(m)
+#define PROF_IDLE(c) profIdle(c)
+
+//Clear the results
+void profReset(void);
+
+//Add a run to a probe (PROF_END)
+void profEnd(unsigned char p, unsigned int start);
+
+//Note the tick a mission stage was reached (PROF_MARK)
+void profMark(unsigned char m);
+
+//Add up the cycles the CPU idled in one tick (PROF_IDLE)
+void profIdle(unsigned int cycles);
+
+#else
+
+#define PROF_BEGIN(p)
+#define PROF_END(p)
+#define PROF_MARK(m)
+#define PROF_IDLE(c)
+
+#endif
+
+
+/*----------------------------------------------------------------------------
+ FLIGHT
+ -----------------------------------------------------------------------------*/
+
+#define FLIGHT_EVENTS 16        // events kept (a power of 2)
+#define FLIGHT_EVENT_BYTES 6
+#define FLIGHT_PART_EVENTS 4    // events in each TELEM_FLIGHT record
+#define FLIGHT_ADDRESS 0x20     // the two 100 byte slots in the data EEPROM, after the CAL block (23 bytes)
+#define FLIGHT_SAMPLE_TICKS 250 // ms between FLIGHT_SAMPLE events
+#define FLIGHT_DUMP_BYTE 'L'    // received on the serial line outside an RFID frame (never hex, 0x02, 0x03, CR or LF), sends the latest log
+
+// event types
+#define FLIGHT_BOOT 1           // reset (the CAP1 byte is the FLIGHT_RESET_ cause)
+#define FLIGHT_MISSION 2        // mission phase changed
+#define FLIGHT_MOVE 3           // movement changed
+#define FLIGHT_SAMPLE 4         // every FLIGHT_SAMPLE_TICKS
+#define FLIGHT_RFID_OK 5        // tag read
+#define FLIGHT_RFID_ERROR 6     // RFID frame dropped
+
+// reset causes
+#define FLIGHT_RESET_POWER 0
+#define FLIGHT_RESET_BROWNOUT 1
+#define FLIGHT_RESET_OTHER 2    // MCLR, watchdog, RESET instruction...
+
+// why a log was committed
+#define FLIGHT_COMMIT_DONE 1    // mission over
+#define FLIGHT_COMMIT_RFID 2    // RFID frame failed
+#define FLIGHT_COMMIT_BROWNOUT 3 // brown-out reset (committed at the next start)
+
+extern unsigned char flightMissed;          // events not recorded while a commit was going on (stops at 255)
+
+//Find the latest log in the EEPROM, commit the ring after a brown-out, call once at start-up (after calLoad)
+void flightInit(void);
+
+//Add an event to the ring
+void flightRecord(unsigned char type, unsigned char cap1, unsigned char cap2, unsigned char move, unsigned char mission);
+
+//Start copying the ring to the EEPROM, in the background
+void flightCommit(unsigned char reason);
+
+//Carry on a commit, run every 1ms by the scheduler
+void flightStep(void);
+
+//Send the latest log from the EEPROM with the telemetry
+void flightDump(void);
+
+//Check whether a commit is still being written
+char flightSaving(void);
+
+//Queue the next part of a dump, returns 0 if there is nothing to send (called by telemTask)
+char flightDumpNext(void);
+
+
+/*----------------------------------------------------------------------------
+ TRACE
+ -----------------------------------------------------------------------------*/
+
+#define TRACE_EVENTS 32         // events queued (a power of 2)
+#define TRACE_EVENT_BYTES 5
+#define TRACE_PART_EVENTS 6     // most events in each TELEM_TRACE record
+
+// event types
+#define TRACE_CAP1 0            // CAP1 pulse width
+#define TRACE_CAP2 1            // CAP2 pulse width
+#define TRACE_RX 2              // byte received on the EUSART
+
+#if TRACE
+
+extern volatile unsigned char traceLost;    // events lost with the queue full (stops at 255)
+
+#define TRACE_EVENT(type, value) traceEvent(type, value)
+
+//Queue an event, called from the interrupts (TRACE_EVENT)
+void traceEvent(unsigned char type, unsigned int value);
+
+//Send the queued events, returns 0 if there were none (called by telemTask)
+char traceSend(void);
+
+#else
+
+#define TRACE_EVENT(type, value)
+
+#endif
+
+
+/*----------------------------------------------------------------------------
+ SPEED
+ -----------------------------------------------------------------------------*/
+
+#define SPEED_TICKS 16          // ms between readings; the bridge is off for the last 2ms of them (the measurement slot)
+#define SPEED_OVERRIDE 0xF5     // OVDCOND in the slot, PWM1 and PWM3 held at their OVDCONS (off) level
+#define SPEED_EMA_SHIFT 1       // moving average weight of a new reading is 1/2^SPEED_EMA_SHIFT
+#define SPEED_KP 16             // gains, in 256ths of % power per ADC count of error
+#define SPEED_KI 8
+#define SPEED_TRIM_MAX 15       // largest trim either way, % power
+#define SPEED_SUM_MAX (SPEED_TRIM_MAX * 256 / SPEED_KI) // sum of errors is clamped to this
+#define SPEED_SCALE_STEP 2      // 256ths both targets move by each correction when a motor is at full duty
+
+#if SPEED
+
+//Set up the ADC, call after initPWM()
+void speedInit(void);
+
+//Read the back-EMF in a measurement slot and correct the motor trims, run every 1ms by the scheduler (never waits for the ADC)
+void speedTask(void);
+
+#endif
+
 
 /*----------------------------------------------------------------------------
  SETUP
@@ -109,17 +715,20 @@ void setAllPorts(void);
 // Function delays the program in seconds
 void delay_s(int sec);
 
-// Converts ASCII characters to HEX (used for checksum)
-unsigned char asciiHexBinary(unsigned char first, unsigned char last);
-
 void setInterrupts(void); // Initalise interrupts
 
 void setInputCapture(void); // Initialise input capture modules (1&2)
 
 void setTimer5(void); // Initialise timer 5
 
+void setTimer2(void); // Initialise timer 2 (1ms scheduler tick)
+
+void setTimer1(void); // Initialise timer 1 (free running, for the profiler)
+
 void setPorts(void); // set appropriate input & digital I/O
 
+void sleepForever(void); // Switch everything off but the LCD and sleep until the next reset
+
 
 #endif	/* HEADER_H */
 
@@ -0,0 +1,105 @@
+#include <xc.h>
+#include "HEADER.h"
+
+/*
+ * IR receiver readings. The low priority interrupt passes every full 16 bit
+ * CAP1BUF/CAP2BUF pulse width to irSample(), which filters it:
+ *
+ *   1. median of the last 3 readings, which throws away single spikes
+ *   2. exponential moving average, value += (median - value) / 2^IR_EMA_SHIFT
+ *
+ * Only compares and shifts are used, so it costs the interrupt very little.
+ * Each channel also counts its samples and keeps the tick of the last one, so
+ * the main program can tell when a reading is old (the beacon has been lost).
+ *
+ * The main program gets both channels at once from irSnapshot(), without
+ * turning the interrupt off. After every sample the interrupt publishes both
+ * channels into the one of two buffers that is not the latest, and then
+ * moves irSeq on to it (a single byte write, which cannot tear). The reader
+ * notes irSeq, copies the buffer it points at and looks at irSeq again: if
+ * it has not moved, no sample was published during the copy, so the pair is
+ * whole and from the same moment. Otherwise the copy is done again (the
+ * beacon pulses every ~50ms, so that is rare). One buffer is always free for
+ * the interrupt, which never waits.
+ *
+ * irBuffer is volatile as well as irSeq, which is what keeps this working:
+ * the compiler must make every access to either one, in program order, so it
+ * cannot move the interrupt's writes to the buffer past irSeq++ or keep the
+ * reader's copy from an earlier pass round the loop. (The PIC18 does not
+ * reorder memory accesses itself, so no barrier instruction is needed.)
+ */
+
+static struct ir_channel irChannel[2]; // filter state, 0 is CAP1, 1 is CAP2 (only used by the interrupt)
+static volatile struct ir_reading irBuffer[2][2]; // published readings of both channels, [buffer][channel]
+static volatile unsigned char irSeq = 0; // samples published, the latest is in irBuffer[irSeq & 1]
+
+//Function to filter a new pulse width, called from the low priority interrupt
+void irSample(unsigned char ch, unsigned int raw) {
+    struct ir_channel *c = &irChannel[ch];
+    volatile struct ir_reading *r;
+    unsigned int lo = c->history[0];
+    unsigned int hi = c->history[1];
+    unsigned int median, value, t;
+    unsigned char i;
+
+    if (!c->seen) { //first reading, nothing to filter against yet
+        lo = raw;
+        hi = raw;
+        c->history[1] = raw;
+        c->value = raw;
+    }
+    c->history[0] = c->history[1];
+    c->history[1] = raw;
+
+    // median of 3
+    if (lo > hi) {
+        t = lo;
+        lo = hi;
+        hi = t;
+    }
+    median = raw;
+    if (raw < lo) {
+        median = lo;
+    } else if (raw > hi) {
+        median = hi;
+    }
+
+    // moving average, kept unsigned
+    value = c->value;
+    if (median > value) {
+        value += (median - value) >> IR_EMA_SHIFT;
+    } else {
+        value -= (value - median) >> IR_EMA_SHIFT;
+    }
+    c->value = value;
+
+    c->samples++;
+    c->stamp = sysTicks;
+    c->seen = 1;
+
+    // publish both channels in the buffer the reader is not using
+    r = irBuffer[(irSeq + 1) & 1];
+    for (i = 0; i < 2; i++) {
+        r[i].value = irChannel[i].value;
+        r[i].samples = irChannel[i].samples;
+        r[i].stamp = irChannel[i].stamp;
+        r[i].seen = irChannel[i].seen;
+    }
+    irSeq++;
+}
+
+//Function to copy the latest readings of both channels, taken at the same moment, without stopping the interrupt
+void irSnapshot(struct ir_reading *cap1, struct ir_reading *cap2) {
+    unsigned char seq;
+
+    do {
+        seq = irSeq;
+        *cap1 = irBuffer[seq & 1][0];
+        *cap2 = irBuffer[seq & 1][1];
+    } while (seq != irSeq); // a sample was published during the copy
+}
+
+//Function to check a reading is recent, returns 0 if it is older than IR_STALE_TICKS (or there has not been one)
+char irFresh(struct ir_reading *r) {
+    return r->seen && (uint16_t) (schedTicks() - r->stamp) <= IR_STALE_TICKS; // the age is right across the tick wrapping
+}
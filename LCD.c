@@ -1,6 +1,5 @@
 #include <xc.h>
 #include <string.h>
-#include <stdio.h>
 #include "HEADER.h"
 
 #pragma config OSC = IRCIO
@@ -13,14 +12,81 @@
 #define LCD_DB6 LATDbits.LD0 //LCD Databit 6
 #define LCD_DB7 LATDbits.LD1 //LCD Databit 7
 
+/*
+ * The rest of the program never talks to the LCD directly. SetLine(),
+ * LCD_String(), LCD_Char(), clearLCD() and customChars() only change a copy of
+ * the screen held in RAM (lcdFrame) and return straight away. Every character
+ * that is changed is marked with LCD_DIRTY (bit 7, which the ASCII text and the
+ * custom characters never use). LCD_Flush() is run by the scheduler every 1ms
+ * and sends at most one byte to the panel each time, so the panel always has
+ * well over the 37-41us it needs between bytes without any delays.
+ * Characters that have not changed are never sent again.
+ *
+ * The initialisation sequence is sent the same way. LCD_Init() only clears
+ * the framebuffer and starts it, and LCD_Flush() sends one step per tick,
+ * waiting out the power-on and clear times by skipping ticks. Anything
+ * written to the screen in the meantime is sent once the panel is ready, so
+ * the rest of the program can start straight away.
+ */
+
+#define LCD_DIRTY 0x80 // cell has changed since it was last sent
+#define LCD_CELLS 32 // 2 lines of 16
+#define LCD_CG_BYTES 16 // custom characters 0 and 1 (8 rows each)
+#define LCD_ADDR_UNKNOWN 0xFF
+#define LCD_INIT_STEPS 9
+
+static unsigned char lcdFrame[LCD_CELLS]; // screen contents, line 1 then line 2
+static unsigned char lcdPending = 0; // set when any cell may be dirty
+static unsigned char lcdCG = 0; // custom character steps left to send
+static unsigned char lcdCursor = 0; // where the next character is written (0-31)
+static unsigned char lcdLineEnd = 16; // characters are clipped at the end of the line
+static unsigned char lcdAddr = LCD_ADDR_UNKNOWN; // DDRAM address of the panel's cursor
+static unsigned char lcdScan = 0; // next cell LCD_Flush() looks at
+static unsigned char lcdInitStep = LCD_INIT_STEPS; // next initialisation step, LCD_INIT_STEPS when done
+static unsigned char lcdWait = 0; // ticks to skip before the next step
+
+// Initialisation sequence - see the data sheet
+#define LCD_NIBBLE 2 // step sends four bits only (the panel is still in 8 bit mode)
+#define LCD_POWER_ON_TICKS 15 // the panel needs 15ms after power on
+
+struct lcd_step {
+    unsigned char byte;
+    unsigned char type; // command (0) or LCD_NIBBLE
+    unsigned char wait; // ticks to skip after it, on top of the next 1ms tick
+};
+
+static const struct lcd_step lcdInit[LCD_INIT_STEPS] = {
+    {0b0011, LCD_NIBBLE, 5}, // 5ms
+    {0b0011, LCD_NIBBLE, 0}, // 200us
+    {0b0011, LCD_NIBBLE, 0}, // 50us
+    {0b0010, LCD_NIBBLE, 0}, // set to four bit mode
+    {0b00101000, 0, 0}, //
+    {0b00001000, 0, 0}, //display off
+    {0b00000001, 0, 2}, //display clear, 2ms
+    {0b00000110, 0, 0}, //entry mode on, cursor direction increase, display not shifted
+    {0b00001100, 0, 0}, //display on, cursor off, blinking off
+};
+
+// Bomb symbol, used for the checksum logo
+static const unsigned char bombChar[8] = {
+    0b00010,
+    0b00101,
+    0b00100,
+    0b01110,
+    0b11111,
+    0b11111,
+    0b11111,
+    0b01110
+};
 
 //Function to toggle the enable bit to read data
 void E_TOG(void) {
-    //don?t forget to put a delay between the on and off
-    //commands! 5us will be plenty.
+    //E must stay high for at least 450ns, and the whole cycle must last 1us:
+    //one instruction is 500ns at 8MHz
     LCD_EN = 1;
-    __delay_us(5); // 5us delay ? remember to define _XTAL_FREQ
+    NOP();
     LCD_EN = 0;
+    NOP();
 }
 
 //Function to send four bits to the LCD
@@ -34,105 +100,172 @@ void LCDout(unsigned char number) {
 
     //toggle the enable bit to send data
     E_TOG();
-    __delay_us(5); // 5us delay
 }
 
 //Function to send data/commands over a 4bit interface
+//The LCD needs 37us (41us for data) before the next byte
 void SendLCD(unsigned char Byte, char type) {
     // set RS pin whether it is a Command (0) or Data/Char (1)
     LCD_RS = type;
     // using type as the argument
     // send high bits of Byte using LCDout function
     LCDout((Byte >> 4) & 0b00001111);
-    __delay_us(10); // 10us delay
     // send low bits of Byte using LCDout function
     LCDout(Byte & 0b00001111);
 }
 
-//Turns characters into a string
+//Function to write one character at the cursor
+void LCD_Char(char c) {
+    unsigned char cell = lcdCursor;
+
+    if (cell >= lcdLineEnd) { //off the end of the line
+        return;
+    }
+    lcdCursor++;
+    if ((lcdFrame[cell] & ~LCD_DIRTY) != (unsigned char) c) { //only changed characters are sent
+        lcdFrame[cell] = c | LCD_DIRTY;
+        lcdPending = 1;
+    }
+}
+
+//Writes a string at the cursor
 void LCD_String(char *string) {
-    //While the data pointed to isn?t a 0x00 do below
+    //While the data pointed to isn't a 0x00 do below
     while (*string != 0) {
-        //Send out the current byte pointed to
+        //Put the current byte pointed to in the framebuffer
         // and increment the pointer
-        SendLCD(*string++, 1);
-        __delay_us(50); //so we can see each character
-        //being printed in turn (remove delay if you want
-        //your message to appear almost instantly)
+        LCD_Char(*string++);
+    }
+}
+
+//Writes an unsigned number at the cursor, right aligned in width characters (see FMT.c)
+void LCD_Unsigned(unsigned int value, unsigned char width) {
+    char text[16];
+
+    if (width > sizeof (text)) { //a line is only 16 characters
+        width = sizeof (text);
+    }
+    fmtUnsigned(text, value, width);
+    for (unsigned char i = 0; i < width; i++) {
+        LCD_Char(text[i]);
+    }
+}
+
+//Writes the low width hex digits of a number at the cursor, with leading zeros (see FMT.c)
+void LCD_Hex(unsigned int value, unsigned char width) {
+    char text[4];
+
+    if (width > sizeof (text)) { //an unsigned int only has 4
+        width = sizeof (text);
+    }
+    fmtHex(text, value, width);
+    for (unsigned char i = 0; i < width; i++) {
+        LCD_Char(text[i]);
     }
 }
 
-//Function to intialise LCD
+//Function to intialise LCD, the sequence itself is sent by LCD_Flush()
 void LCD_Init(void) {
-    // set initial LAT output values (they start up in a random state)
-    //    LATA = 0;
-    //    LATC = 0;
-    //    LATD = 0;
-    // set LCD pins as output (TRIS registers)
-    // Initialisation sequence code - see the data sheet
-    //delay 15mS
-    __delay_ms(15);
-    //send 0b0011 using LCDout
-    LCDout(0b0011);
-    //delay 5ms
-    __delay_ms(5);
-    //send 0b0011 using LCDout
-    LCDout(0b0011);
-    //delay 200us
-    __delay_us(200);
-    //send 0b0011 using LCDout
-    LCDout(0b0011);
-    //delay 50us
-    __delay_us(50);
-    //send 0b0010 using LCDout set to four bit mode
-    LCDout(0b0010);
-    // now use SendLCD to send whole bytes ? send function set, clear
-    // screen, set entry mode, display on etc to finish initialisation
-    SendLCD(0b00101000, 0); //
-    SendLCD(0b00001000, 0); //display off
-    SendLCD(0b00000001, 0); //display clear
-    __delay_ms(2);
-    SendLCD(0b00000110, 0); //entry mode on, cursor direction increase, display not shifted
-    SendLCD(0b00001100, 0); //display on, cursor off, blinking off
+    // the panel is blank once initialised, so is the framebuffer
+    for (unsigned char i = 0; i < LCD_CELLS; i++) {
+        lcdFrame[i] = ' ';
+    }
+    lcdAddr = LCD_ADDR_UNKNOWN;
+    lcdInitStep = 0;
+    lcdWait = LCD_POWER_ON_TICKS;
 }
 
 //Function to put cursor to start of line
 void SetLine(char line) {
-    //Send 0x80 to set line to 1 (0x00 ddram address)
+    //line 1 is cells 0-15, line 2 is cells 16-31
     if (line == 1) {
-        SendLCD(0x80, 0);
+        lcdCursor = 0;
+        lcdLineEnd = 16;
     }
-    //Send 0xC0 to set line to 2 (0x40 ddram address)
     if (line == 2) {
-        SendLCD(0xC0, 0);
+        lcdCursor = 16;
+        lcdLineEnd = 32;
     }
-    __delay_us(50); // 50us delay
 }
 
 //Function to clear LCD
 void clearLCD(void) {
-    SendLCD(0b00000001, 0);
+    //blank every cell and put the cursor at the start of line 1
+    SetLine(2);
+    for (unsigned char i = 0; i < 16; i++) {
+        LCD_Char(' ');
+    }
+    SetLine(1);
+    for (unsigned char i = 0; i < 16; i++) {
+        LCD_Char(' ');
+    }
+    SetLine(1);
 }
 
 // Custom characters function
 void customChars(void) {
-    //CUSTOM CHAR 1 BOMB
-    SendLCD(0x40, 0); // COMMAND
-    SendLCD(0b00010, 1); // THE REST IS DATA
-    SendLCD(0b00101, 1);
-    SendLCD(0b00100, 1);
-    SendLCD(0b01110, 1);
-    SendLCD(0b11111, 1);
-    SendLCD(0b11111, 1);
-    SendLCD(0b11111, 1);
-    SendLCD(0b01110, 1);
-    //CUSTOM CHAR 2 BOMB
-    SendLCD(0b00010, 1);
-    SendLCD(0b00101, 1);
-    SendLCD(0b00100, 1);
-    SendLCD(0b01110, 1);
-    SendLCD(0b11111, 1);
-    SendLCD(0b11111, 1);
-    SendLCD(0b11111, 1);
-    SendLCD(0b01110, 1);
+    //CUSTOM CHAR 1 AND 2 BOMB, sent by LCD_Flush()
+    lcdCG = LCD_CG_BYTES + 1; // CGRAM address command, then the data
+}
+
+//Function to send the next changed byte to the LCD, run every 1ms by the scheduler
+void LCD_Flush(void) {
+    unsigned char cell, c, addr;
+
+    if (lcdWait != 0) { //waiting for the last initialisation step
+        lcdWait--;
+        return;
+    }
+    if (lcdInitStep < LCD_INIT_STEPS) { //initialisation goes before everything
+        if (lcdInit[lcdInitStep].type == LCD_NIBBLE) {
+            LCD_RS = 0;
+            LCDout(lcdInit[lcdInitStep].byte);
+        } else {
+            SendLCD(lcdInit[lcdInitStep].byte, 0);
+        }
+        lcdWait = lcdInit[lcdInitStep].wait;
+        lcdInitStep++;
+        return;
+    }
+
+    if (lcdCG != 0) { //custom characters go first
+        if (lcdCG == LCD_CG_BYTES + 1) {
+            SendLCD(0x40, 0); //CGRAM address 0
+        } else {
+            SendLCD(bombChar[(LCD_CG_BYTES - lcdCG) & 7], 1);
+        }
+        lcdCG--;
+        lcdAddr = LCD_ADDR_UNKNOWN; //the cursor is in CGRAM now
+        return;
+    }
+
+    if (!lcdPending) {
+        return;
+    }
+
+    for (unsigned char n = 0; n < LCD_CELLS; n++) {
+        cell = lcdScan;
+        c = lcdFrame[cell];
+
+        if (c & LCD_DIRTY) {
+            addr = (cell < 16) ? cell : (cell - 16) | 0x40; //DDRAM address of the cell
+
+            if (addr != lcdAddr) {
+                //move the panel's cursor this time, send the character next time
+                SendLCD(0x80 | addr, 0);
+                lcdAddr = addr;
+                return;
+            }
+
+            lcdFrame[cell] = c & ~LCD_DIRTY;
+            SendLCD(c & ~LCD_DIRTY, 1);
+            lcdAddr++; //the panel moves its cursor on by itself
+            lcdScan = (cell + 1) & (LCD_CELLS - 1);
+            return;
+        }
+
+        lcdScan = (cell + 1) & (LCD_CELLS - 1);
+    }
+
+    lcdPending = 0; //nothing left to send
 }
@@ -0,0 +1,117 @@
+#include <xc.h>
+#include "HEADER.h"
+
+/*
+ * Dead reckoning. Works out where the robot is from the motor powers set by
+ * setMotorPWM() and how long they were applied for, so that the robot can
+ * drive straight back to where it started.
+ *
+ * Position (odomX, odomY) is in um from the start, x along the heading the
+ * robot started with. Heading (odomHeading) is a binary angle: the full
+ * 32 bits are one turn, anticlockwise is positive, and it wraps around by
+ * itself. No floating point is used.
+ *
+ * The wheel speed for a given power is taken as proportional to the power
+ * (ODOM_UM_PER_PCT), with nothing below ODOM_DEADBAND. These are rough and
+ * should be measured on the robot.
+ *
+ * NOTE: m_L is the RIGHT motor and m_R the LEFT motor (see DCMOTOR.c).
+ */
+
+#define ODOM_RIGHT 0
+#define ODOM_LEFT 1
+
+// binary angle turned for each um one wheel moves more than the other
+#define ODOM_ANGLE_PER_UM ((int32_t) (4294967296.0 / (6.2831853 * ODOM_TRACK_UM)))
+
+int32_t odomX = 0; // um
+int32_t odomY = 0; // um
+uint32_t odomHeading = 0; // binary angle, 2^32 per turn
+int32_t odomTravel = 0; // um driven along the heading, negative when reversing
+
+static signed char odomPower[2]; // signed power of the right and left wheels
+
+// sin() of 0 to 90 degrees in 65 steps, 16384 = 1
+static const int sinTable[65] = {
+    0, 402, 804, 1205, 1606, 2006, 2404, 2801, 3196, 3590, 3981, 4370, 4756,
+    5139, 5520, 5897, 6270, 6639, 7005, 7366, 7723, 8076, 8423, 8765, 9102,
+    9434, 9760, 10080, 10394, 10702, 11003, 11297, 11585, 11866, 12140, 12406,
+    12665, 12916, 13160, 13395, 13623, 13842, 14053, 14256, 14449, 14635,
+    14811, 14978, 15137, 15286, 15426, 15557, 15679, 15791, 15893, 15986,
+    16069, 16143, 16207, 16261, 16305, 16340, 16364, 16379, 16384
+};
+
+// atan(2^-i) in binary angle, for odomHome()
+static const uint32_t cordicAtan[16] = {
+    536870912, 316933406, 167458907, 85004756, 42667331, 21354465, 10679838,
+    5340245, 2670163, 1335087, 667544, 333772, 166886, 83443, 41722, 20861
+};
+
+//Function to look up sin() of an angle in 256ths of a turn, 16384 = 1
+static int odomSin(unsigned char a) {
+    unsigned char i = a & 0x3F;
+
+    if (a & 0x40) { //second and fourth quarters run backwards through the table
+        i = 64 - i;
+    }
+    return (a & 0x80) ? -sinTable[i] : sinTable[i];
+}
+
+//Function to note the power a motor has just been set to, called from setMotorPWM
+void odomMotor(struct DC_motor *m) {
+    signed char power = m->power;
+
+    if (power < ODOM_DEADBAND) { //too little to turn the wheel
+        power = 0;
+    }
+    if (m->direction) { //reverse
+        power = -power;
+    }
+    odomPower[(m == &motorL) ? ODOM_RIGHT : ODOM_LEFT] = power;
+}
+
+//Function to move the pose on by a number of 1ms ticks at the current motor powers
+void odomStep(unsigned char ticks) {
+    int32_t dr = (int32_t) odomPower[ODOM_RIGHT] * (ODOM_UM_PER_PCT * ticks);
+    int32_t dl = (int32_t) odomPower[ODOM_LEFT] * (ODOM_UM_PER_PCT * ticks);
+    int32_t d = (dr + dl) / 2; // distance moved by the middle of the robot
+    unsigned char a;
+
+    odomHeading += (uint32_t) ((dr - dl) * ODOM_ANGLE_PER_UM); //right wheel faster turns anticlockwise
+    a = (uint32_t) (odomHeading + 0x800000UL) >> 24; //nearest 256th of a turn
+
+    odomX += (d * odomSin(a + 64)) >> 14; //cos
+    odomY += (d * odomSin(a)) >> 14;
+    odomTravel += d;
+}
+
+//Function to work out the heading and distance (um) from the robot to where it started
+void odomHome(uint32_t *bearing, int32_t *distance) {
+    int32_t x = -odomX;
+    int32_t y = -odomY;
+    int32_t t;
+    uint32_t angle = 0;
+
+    /* CORDIC: the vector is rotated onto the x axis in steps of atan(2^-i),
+     * adding up the angles, which leaves its length (times 1.6468) in x */
+    if (x < 0) { //start in the right half, CORDIC only covers +-99 degrees
+        x = -x;
+        y = -y;
+        angle = 0x80000000UL;
+    }
+    for (unsigned char i = 0; i < 16; i++) {
+        t = x;
+        if (y > 0) {
+            x += y >> i;
+            y -= t >> i;
+            angle += cordicAtan[i];
+        } else {
+            x -= y >> i;
+            y += t >> i;
+            angle -= cordicAtan[i];
+        }
+    }
+
+    *bearing = angle;
+    *distance = ((x >> 10) * 19898) >> 5; //x / 1.6468, 19898 = 0.60725 * 32768
+}
@@ -0,0 +1,145 @@
+#include <xc.h>
+#include "HEADER.h"
+
+/*
+ * Path log. Keeps the movements driven on the way to the beacon so they can
+ * be replayed backwards.
+ *
+ * Each entry is one segment, a run of the same movement, with how long it
+ * was actually driven:
+ *
+ *   bits 15-13  movement 'reference code' - 1 (codes 1 to 8, the motion table)
+ *   bits 12-0   time driven, in units (1 to 8191)
+ *
+ * A unit is 2^pathScale ticks of 1ms. The motion task adds the ticks as they
+ * are driven, so the time is measured rather than assumed, and a movement
+ * that carries on (or starts again straight after itself) stays one segment.
+ * Long straight runs and spins take one entry however long they last.
+ *
+ * When the log is full it is compacted instead of dropping movements: the
+ * unit is doubled, every segment is halved and segments of the same movement
+ * that end up next to each other are joined. The half units that are rounded
+ * off are carried to the next segment of the same movement, so the total time
+ * of each movement stays right to within one unit. The return gets coarser,
+ * but it still brings the robot back.
+ *
+ * The log is only kept for the replay (RETURN_DIRECT 0). The direct return
+ * goes by the dead reckoning alone, so none of it is compiled in then.
+ */
+
+#if !RETURN_DIRECT
+
+#define PATH_CODE_SHIFT 13
+#define PATH_RUN_MAX 0x1FFF
+#define PATH_CODES 8
+#define PATH_PIECE_MAX 0x7FFFU  // pathPrev() hands out at most this many ticks at a time (fits an int)
+
+static unsigned int pathLog[PATH_CAPACITY]; // segments, oldest first
+unsigned char pathLength = 0; // segments in pathLog
+unsigned char pathScale = 0; // a unit is 2^pathScale ticks
+static unsigned int pathSub[PATH_CODES]; // ticks of each movement not yet making a whole unit
+
+static unsigned char pathIndex = 0; // reverse iterator: segment being read
+static unsigned int pathLeft = 0; // reverse iterator: units left in that segment
+
+//Function to double the unit and halve every segment to make room
+static void pathCompact(void) {
+    unsigned char carry[PATH_CODES] = {0, 0, 0, 0, 0, 0, 0, 0};
+    unsigned char in, out = 0;
+    unsigned char code;
+    unsigned int run;
+
+    for (in = 0; in < pathLength; in++) {
+        code = pathLog[in] >> PATH_CODE_SHIFT;
+        run = (pathLog[in] & PATH_RUN_MAX) + carry[code];
+        carry[code] = run & 1; // half a new unit, added to the next segment of this movement
+        run >>= 1;
+
+        if (run == 0) {
+            continue;
+        }
+        if (out != 0 && (pathLog[out - 1] >> PATH_CODE_SHIFT) == code
+                && (pathLog[out - 1] & PATH_RUN_MAX) + run <= PATH_RUN_MAX) {
+            pathLog[out - 1] += run; // same movement as the segment before, join them
+        } else {
+            pathLog[out++] = (unsigned int) code << PATH_CODE_SHIFT | run;
+        }
+    }
+
+    pathLength = out;
+    pathScale++;
+}
+
+//Function to add one unit of a movement to the end of the log
+static void pathAppend(unsigned char code) {
+    unsigned int last;
+
+    if (pathLength != 0) {
+        last = pathLog[pathLength - 1];
+        if ((last >> PATH_CODE_SHIFT) == code && (last & PATH_RUN_MAX) != PATH_RUN_MAX) {
+            pathLog[pathLength - 1]++; // carry on the last segment
+            return;
+        }
+    }
+
+    while (pathLength == PATH_CAPACITY && pathScale < PATH_SCALE_MAX) {
+        pathCompact();
+    }
+    if (pathLength == PATH_CAPACITY) { // cannot get any coarser, the movement is lost
+        return;
+    }
+    pathLog[pathLength++] = (unsigned int) code << PATH_CODE_SHIFT | 1;
+}
+
+//Function to record ticks driven of a movement, given by its 'reference code' (1-8)
+void pathAdd(char code, unsigned char ticks) {
+    unsigned char c = code - 1;
+
+    pathSub[c] += ticks;
+    while (pathSub[c] >= (1U << pathScale)) { // the unit can double part way through
+        pathSub[c] -= 1U << pathScale;
+        pathAppend(c);
+    }
+}
+
+//Function to finish recording and start reading the log backwards
+void pathRewind(void) {
+    unsigned char c;
+
+    if (pathLength != 0) {
+        // round the part unit of the last movement to the nearest unit
+        c = pathLog[pathLength - 1] >> PATH_CODE_SHIFT;
+        if (pathSub[c] != 0 && pathSub[c] >= (1U << pathScale) / 2) {
+            pathAppend(c);
+        }
+    }
+    for (c = 0; c < PATH_CODES; c++) {
+        pathSub[c] = 0;
+    }
+
+    pathIndex = pathLength;
+    pathLeft = 0;
+}
+
+//Function to read the log backwards a segment at a time (long ones in pieces). Returns the 'reference code', 0 at the start
+char pathPrev(unsigned int *ticks) {
+    unsigned int units;
+
+    while (pathLeft == 0) {
+        if (pathIndex == 0) { // back at the beginning
+            return 0;
+        }
+        pathIndex--;
+        pathLeft = pathLog[pathIndex] & PATH_RUN_MAX;
+    }
+
+    units = pathLeft;
+    if (units > (PATH_PIECE_MAX >> pathScale)) {
+        units = PATH_PIECE_MAX >> pathScale;
+    }
+    pathLeft -= units;
+    *ticks = units << pathScale;
+    return (pathLog[pathIndex] >> PATH_CODE_SHIFT) + 1;
+}
+
+#endif
@@ -0,0 +1,121 @@
+#include <xc.h>
+#include "HEADER.h"
+
+/*
+ * Profiler. PROF_BEGIN(p)/PROF_END(p) around a piece of code time it with
+ * Timer1, which counts every instruction cycle (500ns) and is never stopped.
+ * Each probe keeps the shortest, longest, total and number of runs, and a
+ * histogram of the run times in powers of 2 cycles:
+ *
+ *   bin 0: 0-1 cycles, bin 1: 2-3, bin 2: 4-7, ... last bin: 2^(PROF_BINS-1) up
+ *
+ * A run longer than 65535 cycles (32ms) wraps and reads short. Time spent in
+ * an interrupt is counted in any probe it interrupts.
+ *
+ * The mission marks are the ticks at which the beacon was found, the RFID was
+ * read and the robot got home. The results are sent as telemetry records
+ * when the mission is done (see telemTask in main.c).
+ *
+ * The scheduler idles the CPU between ticks (SCHED.c) and passes the cycles
+ * it idled for in each tick to profIdle(), which adds them up for the
+ * mission phase it is in: to the beacon, to the RFID, the return, and done
+ * (the number of marks reached so far). With the ticks in each phase, that
+ * gives the share of the time the CPU was awake in each. The interrupts that
+ * wake it are counted as idle time, so it is a little low (see the ir_isr
+ * and rfid_isr probes for how much).
+ *
+ * PROFILE is 0 on the robot (HEADER.h): the probes and marks compile to
+ * nothing and none of this is built but profTimer(), which main() also
+ * times the start-up with. The tables take about 210 bytes of RAM,
+ * more than is left, so a profiled build leaves something else out, or runs
+ * in the simulator (make -C sim profile).
+ */
+
+//Function to read Timer1. Not RD16: its TMR1H latch would be upset by an interrupt reading Timer1 in between
+unsigned int profTimer(void) {
+    unsigned char high, low;
+
+    do {
+        high = TMR1H;
+        low = TMR1L;
+    } while (high != TMR1H); //TMR1L rolled over in between
+    return (unsigned int) high << 8 | low;
+}
+
+#if PROFILE
+
+struct prof_probe prof[PROF_PROBES];
+uint16_t profMarks[PROF_MARKS]; // 0 until reached
+uint32_t profIdleCycles[PROF_PHASES]; // cycles idled in each phase
+unsigned int profPhaseTicks[PROF_PHASES]; // ticks in each phase (stop at 65535)
+
+//Function to clear the results
+void profReset(void) {
+    for (unsigned char p = 0; p < PROF_PROBES; p++) {
+        prof[p].min = 0xFFFF;
+        prof[p].max = 0;
+        prof[p].total = 0;
+        prof[p].count = 0;
+        for (unsigned char b = 0; b < PROF_BINS; b++) {
+            prof[p].hist[b] = 0;
+        }
+    }
+    for (unsigned char m = 0; m < PROF_MARKS; m++) {
+        profMarks[m] = 0;
+    }
+    for (unsigned char ph = 0; ph < PROF_PHASES; ph++) {
+        profIdleCycles[ph] = 0;
+        profPhaseTicks[ph] = 0;
+    }
+}
+
+//Function to add a run to a probe, called by PROF_END
+void profEnd(unsigned char p, unsigned int start) {
+    unsigned int cycles = (uint16_t) (profTimer() - start); //Timer1 wraps at 16 bits, whatever the size of an int
+    struct prof_probe *q = &prof[p];
+    unsigned int c = cycles;
+    unsigned char bin = 0;
+
+    if (cycles < q->min) {
+        q->min = cycles;
+    }
+    if (cycles > q->max) {
+        q->max = cycles;
+    }
+    q->total += cycles;
+    if (q->count != 0xFFFF) {
+        q->count++;
+    }
+
+    while (c > 1 && bin < PROF_BINS - 1) { //log2, by shifting
+        c >>= 1;
+        bin++;
+    }
+    if (q->hist[bin] != 0xFFFF) {
+        q->hist[bin]++;
+    }
+}
+
+//Function to note the tick a mission stage was reached (the first time only)
+void profMark(unsigned char m) {
+    if (profMarks[m] == 0) {
+        profMarks[m] = (uint16_t) (schedTicks() - bootTick) | 1; //never 0, which means not reached
+    }
+}
+
+//Function to add up the cycles the CPU idled in one tick, in the mission phase it is in
+void profIdle(unsigned int cycles) {
+    unsigned char phase = 0;
+
+    for (unsigned char m = 0; m < PROF_MARKS; m++) {
+        if (profMarks[m] != 0) {
+            phase++;
+        }
+    }
+    profIdleCycles[phase] += cycles;
+    if (profPhaseTicks[phase] != 0xFFFF) {
+        profPhaseTicks[phase]++;
+    }
+}
+
+#endif
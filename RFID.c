@@ -0,0 +1,166 @@
+#include <xc.h>
+#include "HEADER.h"
+
+/*
+ * The RFID reader sends each tag as a 16 byte frame:
+ *
+ *   0x02 | 10 ASCII data bytes | 2 ASCII checksum bytes | CR | LF | 0x03
+ *
+ * The serial interrupt only queues the bytes (see RFIDinterrupt in main.c).
+ * rfidPoll() is called from the main loop, takes whatever has arrived since
+ * the last call and decodes the frame a byte at a time, so the robot keeps
+ * steering while a tag is being read. A frame that is too long, or that
+ * stops arriving for RFID_TIMEOUT_TICKS (lost end byte), is dropped instead of
+ * hanging the robot.
+ *
+ * Each pair of ASCII hex digits is turned into a byte as its second digit
+ * arrives (first digit is the high nibble), and the 5 data bytes are XORed
+ * into the checksum as they come, so when the end byte arrives there is
+ * nothing left to work out. A digit that is not hex, or a CR, LF or end byte
+ * out of place, drops the frame straight away.
+ *
+ * The reader sends the tag again and again while it is held in front of it.
+ * A tag only counts once RFID_VOTES frames in a row have passed the checksum
+ * and agree, so a frame corrupted in a way the XOR checksum cannot see is
+ * not enough to send the robot home with the wrong code.
+ *
+ * Outside a frame, FLIGHT_DUMP_BYTE starts sending the flight recorder log
+ * (FLIGHT.c), so a PC plugged into the serial line instead of the reader can
+ * ask for it, and CAL_WRITE_BYTE takes the bytes after it as a calibration
+ * block (CAL.c) until the whole block has come. Neither is a byte a frame is
+ * made of. After a dropped frame the rest of it could still be anything, so
+ * nothing is taken as a command again until the next 0x02, or until the line
+ * has been quiet for RFID_TIMEOUT_TICKS (a PC with no reader).
+ */
+
+char rfidData[RFID_FRAME_LENGTH]; // Holds data from RFID
+unsigned char rfidTag[RFID_TAG_BYTES]; // the tag being voted on, confirmed when rfidPoll() returns RFID_OK
+
+#define RFID_RESYNC 0xFF // rfidIndex after a dropped frame, until the next 0x02
+
+static unsigned char rfidIndex = 0; // next free position in rfidData, 0 while waiting for 0x02
+static uint16_t rfidLastByte = 0; // tick the last byte was taken
+static unsigned char rfidHigh; // high nibble of the pair being decoded
+static unsigned char rfidSum; // XOR of the data bytes so far
+static unsigned char rfidFrameTag[RFID_TAG_BYTES]; // data bytes of the frame being decoded
+static unsigned char rfidVotes = 0; // frames in a row that agreed with rfidTag
+
+//Function to convert an ASCII hex digit, returns 0xFF if it is not one
+static unsigned char rfidHex(unsigned char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    c |= 0x20; //lower case
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    return 0xFF;
+}
+
+//Function to count a frame that passed its checksum, returns 1 once enough in a row agree
+static char rfidVote(void) {
+    unsigned char i;
+    char same = 1;
+
+    for (i = 0; i < RFID_TAG_BYTES; i++) {
+        if (rfidFrameTag[i] != rfidTag[i]) {
+            same = 0;
+        }
+        rfidTag[i] = rfidFrameTag[i];
+    }
+    if (!same || rfidVotes == 0) { //a different tag starts the count again
+        rfidVotes = 1;
+    } else if (rfidVotes < RFID_VOTES) {
+        rfidVotes++;
+    }
+    return rfidVotes >= RFID_VOTES;
+}
+
+//Function to take one byte of a frame, returns RFID_NONE, RFID_OK or RFID_ERROR
+static char rfidByte(unsigned char byte) {
+    unsigned char i = rfidIndex;
+    unsigned char nibble;
+
+    rfidData[i] = byte;
+    rfidIndex = 0; //unless the byte is good
+
+    if (i <= 12) { //data and checksum digits
+        nibble = rfidHex(byte);
+        if (nibble == 0xFF) {
+            return RFID_ERROR;
+        }
+        if (i & 1) { //first digit of a pair
+            rfidHigh = nibble << 4;
+        } else if (i <= 10) { //data byte complete
+            rfidFrameTag[(i >> 1) - 1] = rfidHigh | nibble;
+            rfidSum ^= rfidHigh | nibble;
+        } else if ((rfidHigh | nibble) != rfidSum) { //checksum complete
+            return RFID_ERROR;
+        }
+    } else if ((i == 13 && byte != '\r') || (i == 14 && byte != '\n')) {
+        return RFID_ERROR;
+    } else if (i == 15) {
+        if (byte != 0x03) { //no end byte where it should be
+            return RFID_ERROR;
+        }
+        return rfidVote() ? RFID_OK : RFID_NONE;
+    }
+
+    rfidIndex = i + 1;
+    return RFID_NONE;
+}
+
+//Function to assemble RFID frames from received bytes, returns RFID_NONE, RFID_OK or RFID_ERROR
+char rfidPoll(void) {
+    unsigned char byte;
+    char received = 0;
+    char result;
+
+    while (readSerial(&byte)) {
+        received = 1;
+        rfidLastByte = schedTicks();
+
+        if (calReceive(byte)) { // part of a calibration block from a PC, whatever its value
+            continue;
+        }
+
+        if (byte == 0x02) { // header byte always starts a new frame (it never appears in the data)
+            rfidData[0] = byte;
+            rfidIndex = 1;
+            rfidSum = 0;
+            continue;
+        }
+        if (rfidIndex == RFID_RESYNC) { // the rest of a dropped frame, not commands
+            continue;
+        }
+        if (rfidIndex == 0) { // waiting for the header byte, ignore anything else
+            if (byte == FLIGHT_DUMP_BYTE) { // but a PC on the serial line can ask for the flight recorder log
+                flightDump();
+            } else if (byte == CAL_WRITE_BYTE) { // or send a calibration block
+                calWriteStart();
+            }
+            continue;
+        }
+
+        result = rfidByte(byte);
+        if (result == RFID_ERROR) {
+            rfidIndex = RFID_RESYNC;
+            rfidVotes = 0; // the frames agreeing have to be in a row
+        }
+        if (result != RFID_NONE) {
+            return result;
+        }
+    }
+
+    if (!received && rfidIndex != 0 && (uint16_t) (schedTicks() - rfidLastByte) > RFID_TIMEOUT_TICKS) {
+        // the bytes of a frame arrive about 1ms apart
+        if (rfidIndex == RFID_RESYNC) { // already dropped, the line is free for commands again
+            rfidIndex = 0;
+            return RFID_NONE;
+        }
+        rfidIndex = 0;
+        rfidVotes = 0;
+        return RFID_ERROR;
+    }
+    return RFID_NONE;
+}
@@ -0,0 +1,106 @@
+#include <xc.h>
+#include "HEADER.h"
+
+/*
+ * Cooperative scheduler driven by the Timer2 tick (1ms, see setTimer2()).
+ *
+ * The interrupt only counts ticks. schedRun() is the main loop: each tick it
+ * runs every task whose time has come, in table order, then waits for the
+ * next tick. Tasks must return quickly; anything that takes longer than one
+ * tick has to be split up and carried on next time (see the motion task in
+ * main.c).
+ *
+ * A task that starts more than 'deadline' ticks after it was due counts an
+ * overrun. If it falls more than a whole period behind, the missed runs are
+ * skipped rather than run back to back.
+ *
+ * Between ticks the CPU idles (SLEEP with IDLEN set) instead of spinning: its
+ * clock stops, but the peripherals' keeps running, so the PWM, the timers,
+ * input capture, the ADC and the EUSART carry on, and any of their
+ * interrupts wakes it. It goes back to sleep until the tick has come. With
+ * the profiler on, the time idled is added up for each mission phase
+ * (profIdle, PROF.c).
+ *
+ * Both interrupt levels are off from the check for the tick to the SLEEP:
+ * if the tick came in between, the CPU would sleep through it (or until some
+ * other interrupt) and every task would run late. An enabled interrupt flag
+ * still wakes the CPU with GIEH/GIEL clear; it carries on after the SLEEP,
+ * and the interrupt is taken as soon as they are set again.
+ */
+
+volatile uint16_t sysTicks = 0; // 1ms ticks, counted by the Timer2 interrupt once the scheduler is started
+uint16_t bootTick = 0; // sysTicks at reset
+
+//Function to read sysTicks without the interrupt changing it half way through
+uint16_t schedTicks(void) {
+    uint16_t t;
+
+    do {
+        t = sysTicks;
+    } while (t != sysTicks); //the two bytes are read separately
+    return t;
+}
+
+//Function to idle the CPU until an interrupt wakes it, returns the cycles it idled for (0 without the profiler)
+static unsigned int schedIdle(void) {
+#if PROFILE
+    unsigned int start = profTimer();
+
+    SLEEP();
+    return (uint16_t) (profTimer() - start); //Timer1 wraps at 16 bits, whatever the size of an int
+#else
+    SLEEP();
+    return 0;
+#endif
+}
+
+//Function to run the task table forever
+void schedRun(struct task *tasks, unsigned char count) {
+    uint16_t now = schedTicks();
+    unsigned int late, idle;
+    unsigned char i;
+
+    for (i = 0; i < count; i++) {
+        tasks[i].due = now;
+    }
+    OSCCONbits.IDLEN = 1; // SLEEP idles: the CPU stops, the peripherals do not
+
+    while (1) {
+        PROF_BEGIN(PROF_TICK);
+        for (i = 0; i < count; i++) {
+            struct task *t = &tasks[i];
+
+            if ((int16_t) (now - t->due) < 0) { //not due yet, across the wrap too
+                continue;
+            }
+
+            late = (uint16_t) (now - t->due);
+            if (late > t->deadline && t->overruns != 255) {
+                t->overruns++;
+            }
+            if (t->run) { //empty slots keep their timing but do nothing
+                t->run();
+            }
+
+            t->due += t->period;
+            if (late >= t->period) { //fell a whole period behind
+                t->due = now + t->period;
+            }
+        }
+        PROF_END(PROF_TICK);
+
+        idle = 0;
+        while (1) { //idle until the next tick, other interrupts wake it too
+            INTCON &= 0x3F; //GIEH and GIEL off, so the tick cannot come between the check and the SLEEP
+            if (schedTicks() != now) {
+                break;
+            }
+            idle += schedIdle(); //woken by any enabled interrupt flag
+            INTCON |= 0xC0;
+            NOP(); //the interrupt that woke it is taken here
+        }
+        INTCON |= 0xC0;
+        PROF_IDLE(idle);
+        now = schedTicks();
+    }
+}
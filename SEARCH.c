@@ -0,0 +1,124 @@
+#include <xc.h>
+#include "HEADER.h"
+
+/*
+ * Beacon search. Instead of spinning one way until both IR readings happen to
+ * be in the 'ahead' range (and going round again if a steering decision
+ * came a moment too late), the robot sweeps and keeps the strongest signal it
+ * has seen against its heading (odomHeading, ODOM.c):
+ *
+ *   strength = CAP1/2 + CAP2/2, 0 without fresh readings
+ *
+ * Once the strength has dropped to SEARCH_PEAK_DROP of the peak, the robot
+ * has swept past the beacon. It turns back to the heading of the peak and
+ * hands over to the steering controller there. If the signal has only got
+ * weaker since the sweep started, the robot is turning away from the beacon,
+ * and it sweeps the other way instead.
+ *
+ * The heading the beacon was last tracked at is remembered (searchSeen).
+ * After the signal is lost, the sweep starts back towards it, or towards the
+ * side the robot was steering to if it is still facing that way. It goes
+ * SEARCH_SHORT degrees, and twice as far each time it turns round, until it
+ * is a full turn. Before the beacon has ever been seen, the sweep is a full
+ * turn straight away.
+ *
+ * Directions: MOVE_SPIN_LEFT is clockwise (heading goes down), MOVE_SPIN_RIGHT
+ * anticlockwise, as m_L is the right motor.
+ */
+
+#define SEARCH_SWEEP 0          // sweeping, looking for the peak
+#define SEARCH_AIM 1            // turning back to the peak
+
+#define SEARCH_UNIT_SHIFT 16    // turning is added up in 2^16ths of a turn
+#define SEARCH_TURN (1UL << 16) // one full turn in those units
+
+static char searchPhase = SEARCH_SWEEP;
+static unsigned char searchMove = MOVE_SPIN_LEFT; // spin of the sweep
+static uint32_t searchTurned = 0; // turned since the sweep last turned round (or the aim started)
+static uint32_t searchLimit = SEARCH_TURN; // turn round after this much, SEARCH_TURN or more never
+static uint32_t searchLast = 0; // odomHeading at the last update
+static unsigned int searchPeak = 0; // strongest signal in this sweep
+static char searchRose = 0; // the signal got stronger after the first update, so the peak is not just where the sweep started
+static uint32_t searchPeakHeading = 0; // where it was
+static char searchKnown = 0; // the beacon has been tracked before
+static uint32_t searchBearing = 0; // heading it was last tracked at
+
+//Function to note the beacon is being tracked at the present heading
+void searchSeen(void) {
+    searchKnown = 1;
+    searchBearing = odomHeading;
+}
+
+//Function to start (or restart after losing the beacon) a sweep, side is the last steering turn (right positive). Returns the movement to drive
+unsigned char searchStart(signed char side) {
+    int32_t error;
+
+    searchPhase = SEARCH_SWEEP;
+    searchTurned = 0;
+    searchLast = odomHeading;
+    searchPeak = 0;
+    searchRose = 0;
+
+    if (!searchKnown) { // a whole turn, clockwise as it always was
+        searchMove = MOVE_SPIN_LEFT;
+        searchLimit = SEARCH_TURN;
+    } else { // towards where the beacon was last seen
+        error = (int32_t) (searchBearing - odomHeading);
+        if (error > (int32_t) ODOM_ANGLE(SEARCH_AIM_DEG)) {
+            side = -1; // anticlockwise of here
+        } else if (error < -(int32_t) ODOM_ANGLE(SEARCH_AIM_DEG)) {
+            side = 1;
+        }
+        searchMove = side >= 0 ? MOVE_SPIN_LEFT : MOVE_SPIN_RIGHT;
+        searchLimit = (uint32_t) SEARCH_SHORT * SEARCH_TURN / 360;
+    }
+    return searchMove;
+}
+
+//Function to carry on the sweep with the latest IR readings. Returns the movement to drive, MOVE_STOP when facing the best bearing found
+unsigned char searchUpdate(unsigned int cap1, unsigned int cap2, char fresh) {
+    unsigned int strength = fresh ? (cap1 >> 1) + (cap2 >> 1) : 0;
+    int32_t step = (int32_t) (odomHeading - searchLast);
+    int32_t error;
+
+    searchLast = odomHeading;
+    searchTurned += (uint32_t) (step < 0 ? -step : step) >> SEARCH_UNIT_SHIFT;
+
+    if (searchPhase == SEARCH_AIM) {
+        error = (int32_t) (searchPeakHeading - odomHeading);
+        if (error > -(int32_t) ODOM_ANGLE(SEARCH_AIM_DEG) && error < (int32_t) ODOM_ANGLE(SEARCH_AIM_DEG)) {
+            return MOVE_STOP; // facing the peak
+        }
+        if (searchTurned > SEARCH_TURN) { // never got there, start again
+            return searchStart(0);
+        }
+        return error > 0 ? MOVE_SPIN_RIGHT : MOVE_SPIN_LEFT;
+    }
+
+    if (strength > searchPeak) {
+        searchRose = searchPeak != 0;
+        searchPeak = strength;
+        searchPeakHeading = odomHeading;
+    } else if (searchPeak >= SEARCH_PEAK_MIN
+            && strength < (uint32_t) searchPeak * SEARCH_PEAK_DROP / 256) {
+        if (searchRose) { // past the peak, turn back to it
+            searchPhase = SEARCH_AIM;
+            searchTurned = 0;
+            error = (int32_t) (searchPeakHeading - odomHeading);
+            return error > 0 ? MOVE_SPIN_RIGHT : MOVE_SPIN_LEFT;
+        }
+        // only ever got weaker: turning away from the beacon, sweep the other way
+        searchMove = searchMove == MOVE_SPIN_LEFT ? MOVE_SPIN_RIGHT : MOVE_SPIN_LEFT;
+        searchPeak = strength;
+        searchPeakHeading = odomHeading;
+        searchTurned = 0;
+        return searchMove;
+    }
+
+    if (searchTurned >= searchLimit && searchLimit < SEARCH_TURN) { // sweep the other side, twice as far
+        searchMove = searchMove == MOVE_SPIN_LEFT ? MOVE_SPIN_RIGHT : MOVE_SPIN_LEFT;
+        searchLimit <<= 1;
+        searchTurned = 0;
+    }
+    return searchMove;
+}
@@ -4,10 +4,48 @@
 #pragma config OSC = IRCIO  // internal oscillator
 #define _XTAL_FREQ 8000000 //define _XTAL_FREQ so delay routines work
 
-//Function to wait for data to arrive over serial and to subsequently return
-char getCharSerial(void) {
-    while (!PIR1bits.RCIF); //wait for the data to arrive
-    return RCREG; //return byte in RCREG
+/* Receive ring buffer. RFIDinterrupt() is the only writer of rxHead and
+ * readSerial() the only writer of rxTail, and both are single bytes, so
+ * neither side needs to disable interrupts. */
+volatile unsigned char rxBuffer[RX_BUFFER_SIZE];
+volatile unsigned char rxHead = 0; // next free slot (ISR)
+volatile unsigned char rxTail = 0; // next unread byte (main)
+volatile unsigned char rxDropped = 0; // bytes lost because the buffer was full
+
+/* Transmit ring buffer, the other way round: writeSerial() is the only writer
+ * of txHead and the low priority interrupt the only writer of txTail. The
+ * interrupt sends one byte each time the transmitter is free, and turns
+ * itself off (TXIE) when the buffer is empty. */
+volatile unsigned char txBuffer[TX_BUFFER_SIZE];
+volatile unsigned char txHead = 0; // next free slot (main)
+volatile unsigned char txTail = 0; // next byte to send (ISR)
+
+//Function to take the next received byte out of the ring buffer, returns 0 if empty
+char readSerial(unsigned char *byte) {
+    unsigned char tail = rxTail;
+
+    if (tail == rxHead) {
+        return 0;
+    }
+    *byte = rxBuffer[tail];
+    rxTail = (tail + 1) & (RX_BUFFER_SIZE - 1);
+    return 1;
+}
+
+//Function to queue bytes for sending, returns 0 (and queues nothing) if there is not room for all of them
+char writeSerial(const unsigned char *data, unsigned char len) {
+    unsigned char head = txHead;
+
+    if (len > ((txTail - head - 1) & (TX_BUFFER_SIZE - 1))) {
+        return 0; // never waits for room
+    }
+    while (len--) {
+        txBuffer[head] = *data++;
+        head = (head + 1) & (TX_BUFFER_SIZE - 1);
+    }
+    txHead = head;
+    PIE1bits.TXIE = 1; // the interrupt starts sending
+    return 1;
 }
 
 // Function to set up EUSART registers
@@ -16,12 +54,11 @@ void setupEUSART(void) {
 
     //both need to be 1 even though RC6
     //is an output, check the datasheet!
-    SPBRG = 205; //set baud rate to 9600 (set to 207 -- calibration is 205)
+    SPBRG = cal.spbrg; //set baud rate to 9600 (set to 207 -- calibration is 205, see CAL)
     SPBRGH = 0; // high byte
     BAUDCONbits.BRG16 = 1; //set baud rate scaling to 16 bit mode
     TXSTAbits.BRGH = 1; //high baud rate select bit
     RCSTAbits.CREN = 1; //continous receive mode
     RCSTAbits.SPEN = 1; //enable serial port, other settings default
-    //TXSTAbits.TXEN = 1; //enable transmitter, other settings default  
-    // CURRENTLY ONLY RECEIVING DATA!!!!
+    TXSTAbits.TXEN = 1; //enable transmitter (telemetry), other settings default
 }
@@ -29,13 +29,6 @@ void delay_s(int sec) {
     }
 }
 
-// Converts ASCII characters to HEX (used for checksum)
-unsigned char asciiHexBinary(unsigned char first, unsigned char last) {
-    if (first > '9') first += 9;
-    if (last > '9') last += 9;
-    return (last << 4) | (first & 0x0F);
-}
-
 
 void setInterrupts(void) {
 
@@ -62,6 +55,13 @@ void setInterrupts(void) {
     PIE1bits.RCIE = 1; // Interrupt EUSART Receive Interrupt Enabled
     IPR1bits.RC1IP = 1; // Set EUSART receive interrupt as HIGH priority
 
+    // TELEMETRY (enabled by writeSerial when there is something to send)
+    IPR1bits.TXIP = 0; // Set EUSART transmit interrupt as LOW priority
+
+    // TIMER2 (1ms tick)
+    PIE1bits.TMR2IE = 1; // Timer2 to PR2 match interrupt enable
+    IPR1bits.TMR2IP = 0; // Set Timer2 interrupt as LOW priority
+
 }
 
 void setInputCapture(void) {
@@ -90,6 +90,28 @@ void setTimer5(void) {
     TMR5L = 0;
 }
 
+void setTimer2(void) {
+    // TIMER2 SETUP
+    PR2 = 124; // Timer2 counts 0 to 124 (125 counts)
+    T2CON = 0b00011101; // Postscaler 1:4, Timer2 on, prescaler 1:4
+
+    /* [Timer2 counts at FOSC/4/4 = 500kHz (2us). 125 counts is 250us, and the
+     * 1:4 postscaler sets TMR2IF every 4 matches, so the interrupt comes every
+     * 1ms. It is the scheduler tick (sysTicks, SCHED.c)] */
+}
+
+void setTimer1(void) {
+    // TIMER1 SETUP
+    TMR1H = 0;
+    TMR1L = 0;
+    T1CON = 0b00000001; // 8 bit reads, prescaler 1:1, internal clock, Timer1 on
+
+    /* [Timer1 counts every instruction cycle (FOSC/4 = 2MHz, 500ns) and is
+     * never stopped or reloaded. Its interrupt is not used: it is the clock
+     * for the profiler (PROF.c), which only looks at differences, so it can
+     * overflow (every 32.8ms) freely] */
+}
+
 void setPorts(void) {
     // SET PORTS
     TRISAbits.RA2 = 1; // Input for CAP1
@@ -97,4 +119,41 @@ void setPorts(void) {
     ANSEL0bits.ANS2 = 0; // Force digital I/O
     ANSEL0bits.ANS3 = 0; // Force digital I/O
 
-}
\ No newline at end of file
+}
+//Function to switch off everything but the LCD and sleep until the next reset
+void sleepForever(void) {
+    INTCON = 0; // GIEH, GIEL and the INT0, port B change and Timer0 interrupts off
+    PIE1 = 0; // RFID RX, telemetry TX, Timer2
+    PIE2 = 0;
+    PIE3 = 0; // input capture
+
+    PDC0L = 0; // no drive to either motor
+    PDC0H = 0;
+    PDC1L = 0;
+    PDC1H = 0;
+    LATBbits.LB0 = 0;
+    LATBbits.LB2 = 0;
+    PWMCON1 = 0x00; // output overrides act at once (OSYNC 0), no special event trigger
+    OVDCONS = 0x00; // overridden outputs are inactive
+    OVDCOND = 0x00; // every PWM output overridden
+    PTCON1 = 0x00; // PWM time base off
+    ADCON0 = 0; // ADC off
+
+    /* [The new duties would only be latched at the end of the PWM period, and
+     * stopping the oscillator could leave a PWM pin high for good, so the
+     * outputs are forced off with the override instead, which does not wait
+     * for the time base, and then the time base is stopped.
+     *
+     * The LCD keeps showing what it was sent for as long as it has power.
+     * Without IDLEN, SLEEP stops the oscillator and everything clocked from
+     * it. Nothing is left to wake it: INT1 and INT2 (INTCON3) are never
+     * turned on, the EUSART is not clocked and its wake-up on RX (WUE) is
+     * off, so RFID frames are ignored, and with PIE1-3 clear no peripheral
+     * flag can wake it either. Only a reset starts the program again
+     * (MCLR, brown-out, or the watchdog if it is ever turned on, hence the
+     * loop)] */
+    OSCCONbits.IDLEN = 0;
+    while (1) {
+        SLEEP();
+    }
+}
@@ -0,0 +1,177 @@
+#include <xc.h>
+#include "HEADER.h"
+
+/*
+ * Wheel speed regulation. The two motors do not turn at the same speed for
+ * the same power, and by how much changes with the battery and the floor, so
+ * the motion table carries fudge factors (93/95 ahead, 98/95 back) that are
+ * only right on the floor they were found on. Instead, each motor's speed is
+ * measured from its back-EMF, and its duty is trimmed until the speed is what
+ * its power asks for: cal.emfFull at 100%. That reading is in the calibration
+ * block (CAL.c) rather than compiled in, as it depends on the motors and the
+ * dividers: the default (CAL_EMF_FULL) has not been measured on the robot,
+ * and is set with sim/calblock.c (emf_full) over the serial line once it
+ * has. Too high a figure shows as both targets held down (speedScale), too
+ * low as the robot going slower than before. With SPEED 0 the motion table
+ * keeps the powers found on the robot instead (MOTION_POWER in DCMOTOR.c).
+ *
+ * Each motor is wired, through a divider, to a spare analog pin: the right
+ * motor (m_L) to AN0/RA0 and the left (m_R) to AN1/RA1. The voltage across a
+ * motor is only its back-EMF once the bridge has stopped driving it and the
+ * current in the winding has run down through the flyback diodes, which takes
+ * a few hundred us at full power. Until then the pin reads the diode clamp.
+ * The off time inside a 100us PWM period is far too short for that, so
+ * the readings are taken in a measurement slot instead:
+ *
+ *   tick SPEED_TICKS - 2   both bridge outputs are overridden to their off
+ *                          level (OVDCOND/OVDCONS, acting at once)
+ *   tick SPEED_TICKS - 1   a whole tick later the flyback is over and the
+ *                          voltage has settled; the ADC samples both pins at
+ *                          the same instant (simultaneous mode) and starts
+ *                          converting them
+ *   tick SPEED_TICKS       the conversions (24us) are long done: the outputs
+ *                          go back to the PWM, the readings are taken from
+ *                          the FIFO and the trims are corrected
+ *
+ * so nothing waits for the ADC, and the motors coast for 2ms in every
+ * SPEED_TICKS, which the trims make up for. Should a conversion somehow not
+ * be done by the next tick, that round is left out. The off level of each output is kept in step with its motor's
+ * direction by setMotorPWM, as the bridge inverts the duty in reverse.
+ *
+ * A PI controller works out each motor's trim (% power added on top by
+ * setMotorPWM) from the difference between its filtered reading and its
+ * target. When a motor cannot get to its target even at full duty (a soft
+ * floor, a flat battery), both targets are scaled down (speedScale) so the
+ * wheels still turn at the same speed as each other, and the scale creeps
+ * back up once there is room again. A motor below ODOM_DEADBAND, or running
+ * down to change direction, is left untrimmed and its controller is reset.
+ *
+ * The dead reckoning (ODOM.c) still goes by the powers, which the wheels now
+ * follow much more closely.
+ */
+
+#if SPEED
+
+#define SPEED_ROOM 0            // both motors have room to speed up
+#define SPEED_NEAR_TOP 1        // a motor is within 2% of full duty
+#define SPEED_SHORT 2           // a motor is at full duty and still too slow
+
+static unsigned int speedEmf[2]; // filtered back-EMF of the right (m_L) and left (m_R) motor, ADC counts
+static int speedSum[2]; // sums of errors
+static unsigned int speedScale = 256; // both targets are scaled by this, 256ths
+static unsigned char speedCount = 0; // ticks since the last correction
+
+//Function to set up the ADC
+void speedInit(void) {
+    TRISAbits.RA0 = 1; // Input for the right motor's back-EMF
+    TRISAbits.RA1 = 1; // Input for the left motor's back-EMF
+    ANSEL0bits.ANS0 = 1; // Analog
+    ANSEL0bits.ANS1 = 1;
+
+    ADCHS = 0b00000000; // group A is AN0, group B is AN1
+    ADCON1 = 0b00010000; // AVdd/AVss references, FIFO enabled
+    ADCON2 = 0b10000001; // right justified, no acquisition delay (held at GO), FOSC/8
+    ADCON3 = 0b00000000; // started by setting GO
+    ADCON0 = 0b00011001; // single shot, groups A and B sampled together (STNM1), A/D on
+}
+
+//Function to take a reading into a motor's filter
+static void speedSample(unsigned char i, unsigned int value) {
+    unsigned int emf = speedEmf[i];
+
+    if (value > emf) {
+        emf += (value - emf) >> SPEED_EMA_SHIFT;
+    } else {
+        emf -= (emf - value) >> SPEED_EMA_SHIFT;
+    }
+    speedEmf[i] = emf;
+}
+
+//Function to change a motor's trim
+static void speedTrim(struct DC_motor *m, signed char trim) {
+    if (m->trim != trim) {
+        m->trim = trim;
+        setMotorPWM(m);
+    }
+}
+
+//Function to correct a motor's trim, returns SPEED_ROOM, SPEED_NEAR_TOP or SPEED_SHORT
+static unsigned char speedCorrect(unsigned char i) {
+    struct DC_motor *m = i ? &motorR : &motorL;
+    unsigned int target;
+    int error, trim, duty;
+
+    if (m->power < ODOM_DEADBAND || m->direction != m->targetDirection) { // stopped, or about to reverse
+        speedSum[i] = 0;
+        speedTrim(m, 0);
+        return SPEED_ROOM;
+    }
+
+    target = (unsigned int) ((uint32_t) m->power * cal.emfFull * speedScale / 25600);
+    error = (int) target - (int) speedEmf[i];
+    duty = m->power + m->trim;
+
+    if (!(duty >= 100 && error > 0)) { // no wind-up while the motor is flat out
+        speedSum[i] += error;
+        if (speedSum[i] > SPEED_SUM_MAX) {
+            speedSum[i] = SPEED_SUM_MAX;
+        } else if (speedSum[i] < -SPEED_SUM_MAX) {
+            speedSum[i] = -SPEED_SUM_MAX;
+        }
+    }
+
+    trim = (error * SPEED_KP + speedSum[i] * SPEED_KI) / 256;
+    if (trim > SPEED_TRIM_MAX) {
+        trim = SPEED_TRIM_MAX;
+    } else if (trim < -SPEED_TRIM_MAX) {
+        trim = -SPEED_TRIM_MAX;
+    }
+    speedTrim(m, trim);
+
+    if (duty >= 100 && error > 0) {
+        return SPEED_SHORT;
+    }
+    return duty + 2 >= 100 ? SPEED_NEAR_TOP : SPEED_ROOM;
+}
+
+//Function to take the back-EMF readings in a measurement slot and correct the motor trims, run every 1ms
+void speedTask(void) {
+    unsigned char i, low, right, left;
+
+    if (++speedCount < SPEED_TICKS - 2) {
+        return;
+    }
+    if (speedCount == SPEED_TICKS - 2) { // open the slot: the bridge stops driving both motors
+        OVDCOND = SPEED_OVERRIDE;
+        return;
+    }
+    if (speedCount == SPEED_TICKS - 1) { // both held now, a tick after the bridge let go
+        ADCON0bits.GO_DONE = 1; // 24us for the two conversions, taken next tick
+        return;
+    }
+    speedCount = 0;
+    OVDCOND = 0xFF; // the PWM drives every output again
+
+    if (ADCON0bits.GO_DONE) { // still converting a whole tick later, leave this round out
+        return;
+    }
+
+    while (!ADCON1bits.BFEMT) { // group A (AN0) is always at an even place in the FIFO
+        i = ADCON1bits.ADPNT & 1;
+        low = ADRESL;
+        speedSample(i, (unsigned int) ADRESH << 8 | low); // reading ADRESH moves on to the next
+    }
+    ADCON1bits.BFOVFL = 0;
+
+    right = speedCorrect(0);
+    left = speedCorrect(1);
+    if (right == SPEED_SHORT || left == SPEED_SHORT) { // hold the other one back to match
+        if (speedScale > 128) {
+            speedScale -= SPEED_SCALE_STEP;
+        }
+    } else if (right == SPEED_ROOM && left == SPEED_ROOM && speedScale < 256) {
+        speedScale += SPEED_SCALE_STEP;
+    }
+}
+
+#endif
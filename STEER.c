@@ -0,0 +1,55 @@
+#include <xc.h>
+#include "HEADER.h"
+
+/*
+ * Steering controller. Turns the difference between the two IR receivers into
+ * a continuous turn, instead of picking turnSlightLeft, turnSlightRight or
+ * fullSpeedAhead:
+ *
+ *   error = (CAP1 - CAP2) >> STEER_ERROR_SHIFT
+ *   turn  = (Kp * error + Ki * sum of errors + Kd * change in error) / 256
+ *
+ * The gains are in 256ths (cal.kp etc., so they can be changed while tuning)
+ * and the turn is in % of motor power, limited to +-STEER_TURN_MAX. A positive
+ * turn is to the right, as CAP1 reading more than CAP2 meant turnSlightRight.
+ *
+ * The sum of errors is clamped to +-STEER_SUM_MAX so it cannot wind up while
+ * the robot is searching or the motors are already at full power. It is what
+ * takes out the chassis veer, which used to be allowed for by making
+ * turnSlightRight run 3 times as long.
+ */
+
+static int steerSum = 0; // sum of errors, clamped
+static int steerLast = 0; // error at the last update
+
+//Function to forget the controller's history, called when it starts steering
+void steerReset(void) {
+    steerSum = 0;
+    steerLast = 0;
+}
+
+//Function to work out the turn (% power, right positive) from the two IR readings, called every control tick
+signed char steerUpdate(unsigned int cap1, unsigned int cap2) {
+    int error = (int) (((int32_t) cap1 - (int32_t) cap2) >> STEER_ERROR_SHIFT);
+    int32_t turn;
+
+    steerSum += error;
+    if (steerSum > STEER_SUM_MAX) {
+        steerSum = STEER_SUM_MAX;
+    } else if (steerSum < -STEER_SUM_MAX) {
+        steerSum = -STEER_SUM_MAX;
+    }
+
+    turn = (int32_t) cal.kp * error
+            + (int32_t) cal.ki * steerSum
+            + (int32_t) cal.kd * (error - steerLast);
+    steerLast = error;
+
+    turn >>= 8; //gains are in 256ths
+    if (turn > STEER_TURN_MAX) {
+        turn = STEER_TURN_MAX;
+    } else if (turn < -STEER_TURN_MAX) {
+        turn = -STEER_TURN_MAX;
+    }
+    return (signed char) turn;
+}
@@ -0,0 +1,188 @@
+#include <xc.h>
+#include "HEADER.h"
+
+/*
+ * Telemetry. Records are framed here and queued with writeSerial(), which
+ * never waits: if the transmit buffer has no room for a whole frame, the
+ * record is dropped and counted instead. Each record carries a sequence
+ * number and the drop count, so the host can see what is missing.
+ *
+ *   TELEM_SYNC  length  type  sequence  ...  checksum
+ *
+ * The checksum makes everything after the sync byte add up to 0, so the
+ * decoder can find the next frame again after a lost byte.
+ */
+
+unsigned char telemDropped = 0; // records not sent (stops at 255)
+static unsigned char telemSeq = 0; // sequence number of the next record
+
+//Function to frame a payload and queue it, returns 0 if there was no room
+static char telemSend(unsigned char *frame, unsigned char length) {
+    unsigned char sum = 0;
+
+    frame[0] = TELEM_SYNC;
+    frame[1] = length;
+    for (unsigned char i = 1; i < length + 2; i++) {
+        sum += frame[i];
+    }
+    frame[length + 2] = -sum;
+
+    if (!writeSerial(frame, length + 3)) {
+        if (telemDropped != 255) {
+            telemDropped++;
+        }
+        return 0;
+    }
+    return 1;
+}
+
+//Function to queue a state record, dropped (and counted) if the transmit buffer is full
+void telemState(struct telem_state *t) {
+    unsigned char frame[TELEM_STATE_LENGTH + 3];
+    unsigned char *p = frame + 2;
+
+    *p++ = TELEM_STATE;
+    *p++ = telemSeq;
+    *p++ = t->ticks;
+    *p++ = t->ticks >> 8;
+    *p++ = t->cap1;
+    *p++ = t->cap1 >> 8;
+    *p++ = t->cap2;
+    *p++ = t->cap2 >> 8;
+    *p++ = t->move;
+    *p++ = t->right;
+    *p++ = t->left;
+    *p++ = t->pathRuns;
+    *p++ = t->pathScale;
+    *p++ = t->mission;
+    *p++ = telemDropped;
+
+    telemSeq++; // counts dropped records too, so gaps show on the host
+    telemSend(frame, TELEM_STATE_LENGTH);
+}
+
+#if PROFILE
+
+//Function to queue one profiler probe's results, returns 0 if it was dropped
+char telemProfile(unsigned char p) {
+    unsigned char frame[TELEM_PROFILE_LENGTH + 3];
+    unsigned char *q = frame + 2;
+    struct prof_probe *r = &prof[p];
+
+    *q++ = TELEM_PROFILE;
+    *q++ = telemSeq;
+    *q++ = p;
+    *q++ = r->min;
+    *q++ = r->min >> 8;
+    *q++ = r->max;
+    *q++ = r->max >> 8;
+    *q++ = r->count;
+    *q++ = r->count >> 8;
+    *q++ = r->total;
+    *q++ = r->total >> 8;
+    *q++ = r->total >> 16;
+    *q++ = r->total >> 24;
+    for (unsigned char b = 0; b < PROF_BINS; b++) {
+        *q++ = r->hist[b];
+        *q++ = r->hist[b] >> 8;
+    }
+
+    telemSeq++;
+    return telemSend(frame, TELEM_PROFILE_LENGTH);
+}
+
+//Function to queue the mission marks, returns 0 if it was dropped
+char telemMarks(void) {
+    unsigned char frame[TELEM_MARKS_LENGTH + 3];
+    unsigned char *q = frame + 2;
+
+    *q++ = TELEM_MARKS;
+    *q++ = telemSeq;
+    for (unsigned char m = 0; m < PROF_MARKS; m++) {
+        *q++ = profMarks[m];
+        *q++ = profMarks[m] >> 8;
+    }
+
+    telemSeq++;
+    return telemSend(frame, TELEM_MARKS_LENGTH);
+}
+
+//Function to queue the ticks and the idle time (ms) of each mission phase, returns 0 if it was dropped
+char telemPower(void) {
+    unsigned char frame[TELEM_POWER_LENGTH + 3];
+    unsigned char *q = frame + 2;
+    unsigned int idle;
+
+    *q++ = TELEM_POWER;
+    *q++ = telemSeq;
+    for (unsigned char ph = 0; ph < PROF_PHASES; ph++) {
+        idle = profIdleCycles[ph] / 2000; // instruction cycles to ms
+        *q++ = profPhaseTicks[ph];
+        *q++ = profPhaseTicks[ph] >> 8;
+        *q++ = idle;
+        *q++ = idle >> 8;
+    }
+
+    telemSeq++;
+    return telemSend(frame, TELEM_POWER_LENGTH);
+}
+
+#endif
+
+//Function to queue part of a flight recorder log, returns 0 if it was dropped
+char telemFlight(unsigned char part, unsigned char count, unsigned char reason, unsigned char seq, unsigned char *events) {
+    unsigned char frame[TELEM_FLIGHT_LENGTH + 3];
+    unsigned char *q = frame + 2;
+
+    *q++ = TELEM_FLIGHT;
+    *q++ = telemSeq;
+    *q++ = part;
+    *q++ = count;
+    *q++ = reason;
+    *q++ = seq;
+    for (unsigned char i = 0; i < FLIGHT_PART_EVENTS * FLIGHT_EVENT_BYTES; i++) {
+        *q++ = events[i];
+    }
+
+    telemSeq++;
+    return telemSend(frame, TELEM_FLIGHT_LENGTH);
+}
+
+//Function to queue a calibration report, returns 0 if it was dropped
+char telemCal(unsigned char status, unsigned char *block) {
+    unsigned char frame[TELEM_CAL_LENGTH + 3];
+    unsigned char *q = frame + 2;
+
+    *q++ = TELEM_CAL;
+    *q++ = telemSeq;
+    *q++ = status;
+    for (unsigned char i = 0; i < CAL_BYTES; i++) {
+        *q++ = block[i];
+    }
+
+    telemSeq++;
+    return telemSend(frame, TELEM_CAL_LENGTH);
+}
+
+#if TRACE
+
+//Function to queue trace events, returns 0 if they were dropped
+char telemTrace(unsigned char count, unsigned char *events) {
+    unsigned char frame[TELEM_TRACE_LENGTH(TRACE_PART_EVENTS) + 3];
+    unsigned char *q = frame + 2;
+
+    *q++ = TELEM_TRACE;
+    *q++ = telemSeq;
+    *q++ = traceLost;
+    for (unsigned char i = 0; i < count * TRACE_EVENT_BYTES; i++) {
+        *q++ = events[i];
+    }
+
+    if (!telemSend(frame, TELEM_TRACE_LENGTH(count))) {
+        return 0; // the events are sent again next time, so it is not a gap
+    }
+    telemSeq++;
+    return 1;
+}
+
+#endif
@@ -0,0 +1,76 @@
+#include <xc.h>
+#include "HEADER.h"
+
+/*
+ * Trace capture. With TRACE set (HEADER.h), every IR pulse width the input
+ * capture interrupt takes and every byte the RFID interrupt receives is
+ * queued with the tick it arrived at, and the telemetry task sends them as
+ * TELEM_TRACE records in place of the state records. A run on the floor can
+ * then be played back through the firmware on a PC (sim/replay.c), as many
+ * times as needed, to see what a change to a threshold would have done.
+ *
+ * Each event is 5 bytes: type (TRACE_CAP1, TRACE_CAP2, TRACE_RX), sysTicks
+ * and the pulse width or the byte. Both interrupts add to the queue, so the
+ * high priority one is held off while an event is written. (A byte that
+ * arrives just as the low priority one is counting the tick can be stamped
+ * 256ms out, which the replay puts up with.) When the queue is full the event
+ * is lost and counted in traceLost, which every record carries.
+ *
+ * With TRACE set to 0 none of this is built and TRACE_EVENT compiles to
+ * nothing.
+ */
+
+#if TRACE
+
+static unsigned char traceLog[TRACE_EVENTS][TRACE_EVENT_BYTES];
+static volatile unsigned char traceHead = 0; // next event to write (interrupts)
+static volatile unsigned char traceTail = 0; // next event to send (telemetry task)
+volatile unsigned char traceLost = 0; // events lost with the queue full (stops at 255)
+
+//Function to queue an event, called from the interrupts
+void traceEvent(unsigned char type, unsigned int value) {
+    unsigned char gie = INTCON & 0xC0;
+    unsigned char next;
+    unsigned char *e;
+
+    INTCON &= 0x3F; // the other interrupt adds events too
+    next = (traceHead + 1) & (TRACE_EVENTS - 1);
+    if (next == traceTail) {
+        if (traceLost != 255) {
+            traceLost++;
+        }
+    } else {
+        e = traceLog[traceHead];
+        e[0] = type;
+        e[1] = sysTicks - bootTick; // from reset, as the replay starts there
+        e[2] = (uint16_t) (sysTicks - bootTick) >> 8;
+        e[3] = value;
+        e[4] = value >> 8;
+        traceHead = next;
+    }
+    INTCON |= gie;
+}
+
+//Function to send the queued events, returns 0 if there were none
+char traceSend(void) {
+    unsigned char events[TRACE_PART_EVENTS * TRACE_EVENT_BYTES];
+    unsigned char count = 0;
+    unsigned char tail = traceTail;
+
+    while (tail != traceHead && count < TRACE_PART_EVENTS) {
+        for (unsigned char i = 0; i < TRACE_EVENT_BYTES; i++) {
+            events[count * TRACE_EVENT_BYTES + i] = traceLog[tail][i];
+        }
+        tail = (tail + 1) & (TRACE_EVENTS - 1);
+        count++;
+    }
+    if (count == 0) {
+        return 0;
+    }
+    if (telemTrace(count, events)) { // otherwise sent again next time
+        traceTail = tail;
+    }
+    return 1;
+}
+
+#endif
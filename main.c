@@ -7,7 +7,6 @@
  * ------------------------------------ */
 
 
-#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <xc.h>
@@ -16,8 +15,8 @@
 #include "HEADER.h" // File contains functions for DC MOTOR, LCD, LED, SERIAL, & SETUP
 
 #pragma config OSC = IRCIO  // Set internal oscillator
+#pragma config BOREN = ON, BORV = 42 // Brown-out reset below 4.2V, the flight recorder saves its log after one
 #define _XTAL_FREQ 8000000 // Set _XTAL_FREQ so that __delay_ functions work
-#define PWMcycle 200
 
 /*============================================================================*/
 /* TABLE OF CONTENTS
@@ -29,15 +28,26 @@
  *      Details how the program works. To be used as reference
  *
  * 3. MAIN FUNCTION
- *      This is the main function of the program
- *      i.  Navigate to beacon
- *      ii. Return to original location
+ *      Sets everything up and starts the scheduler
  *
- * 4. HIGH PRIORITY INTERRUPT
- *      Triggered by the EUSART interrupt flag being flagged
+ * 4. TASKS
+ *      Run by the scheduler
+ *      i.   Navigate to beacon
+ *      ii.  Return to original location
+ *      iii. LEDs
+ *      iv.  Telemetry
+ *      v.   Flight recorder
  *
- * 5. LOW PRIORITY INTERRUPT
+ * 5. HIGH PRIORITY INTERRUPT
+ *      Triggered by the EUSART interrupt flag being flagged. Queues the byte
+ *
+ * 6. RFID FRAMES
+ *      Called from the sensing task. Checks for a complete, valid RFID frame
+ *
+ * 7. LOW PRIORITY INTERRUPT
  *      Triggered by CAP1/CAP2 (IR Receivers). Stores their read values
+ *      Triggered by Timer2 every 1ms. Counts the scheduler tick
+ *      Triggered by the EUSART transmitter. Sends the next telemetry byte
  *
  *
  */
@@ -50,139 +60,295 @@
 /*                             GLOBAL VARIABLES                               */
 /*============================================================================*/
 /*============================================================================*/
-unsigned int cap1Buffer = 0; // Stores high byte CAP1BUFH - IR READINGS
-unsigned int cap2Buffer = 0; // Stores high byte CAP2BUFH - IR READINGS
-char lcdBuffer1; // Buffer variable used for LCD line 1
-char lcdBuffer2; // Buffer variable used for LCD line 2
-
 int rfidFlag = 0; // Goes HIGH when RFID is read
-char rfidData[16]; // Holds data from RFID
 
 int lcdFlag = 0; // Goes high to help clear LCD once
 
-int count = 0; // count through path[255] array
-char path[255]; // Array holds individual movements of robot
-// Read in reverse to invert movements, and return to start
-
-int search = 0; // Goes high when signal is found from both IR receivers
-
 /* Goes high after initial sweep. This prevents recording the first turning
  * movements. */
 int startFlag = 0;
 
+// Where the robot is in its mission (see the overview)
+#define MISSION_START 0 // start screen
+#define MISSION_SEARCH 1 // spinning to find the beacon
+#define MISSION_TRACK 2 // driving towards the beacon
+#define MISSION_RETURN 3 // replaying the path backwards
+#define MISSION_DONE 4 // showing the disarm code
+char mission = MISSION_START;
+
+// Timings, in 1ms scheduler ticks
+#define SPLASH_TICKS 1000 // start screen is shown for 1 second
+#define STEER_TICKS 9 // steering decision every 9ms
+#define LED_TICKS 89 // LED array flashes every 89ms
+#define PARK_TICKS 30000U // the disarm code is flashed for 30 seconds, then the robot parks in deep sleep
+
+/* 1: start the beacon sweep straight away, with the start screen still up
+ * 0: wait for the start screen (SPLASH_TICKS) before moving */
+#define FAST_BOOT 1
+char splash = 1; // start screen is showing
+char bootShown = 0; // time to first motion is on the start screen
+
+/* With the path log replay (RETURN_DIRECT 0, HEADER.h):
+ * 1: each movement is replayed with both motors scaled up until the faster is
+ *    at full power, for proportionally less time (same track, quicker return)
+ * 0: each movement is replayed at its table power for the time it was driven */
+#define RETURN_FAST 1
+
+#define RETURN_TURN 0 // turning to face home (or directly away from it)
+#define RETURN_DRIVE 1 // driving the straight leg home
+#define RETURN_AIM ODOM_ANGLE(2) // pointing home when within 2 degrees
+char returnPhase = RETURN_TURN;
+char returnBack = 0; // the leg home is driven backwards
+uint32_t homeBearing = 0; // heading to turn to (binary angle)
+int32_t homeDistance = 0; // um to drive
+int32_t returnStart = 0; // odomTravel when the leg home started
+
+char moveCode = 0; // reference code of the movement being driven (or replayed), 0 when stopped (MOVE_ID on the direct return)
+uint16_t moveLastTick = 0; // tick the motion task last ran
+#if !RETURN_DIRECT
+int replayLeft = 0; // ticks left of the path segment being replayed
+#endif
+char ledState = 0; // LED array on/off for flashing
+uint16_t doneTick = 0; // tick the disarm code was shown at
+
+unsigned char shownSamples = 0; // IR readings on the debug line (sum of the sample counts)
+signed char steerTurn = 0; // turn set by the steering controller, % power (right positive)
+
+unsigned char flightMission = MISSION_START; // mission phase last recorded by the flight recorder
+char flightMove = 0; // movement last recorded
+uint16_t flightLast = 0; // tick of the last event recorded
+char flightRfidSaved = 0; // the log has been committed for an RFID error (once a run, to spare the EEPROM)
+
+#if PROFILE
+unsigned char profNext = 0; // next profiler record to send when the mission is done (PROF_PROBES is the marks, then the idle time)
+char profSlow = 0; // telemetry runs alternately send and skip while sending the profiler records
+#endif
+
 
 
 /*----------------------------------------------------------------------------*/
 /*----------------------------------------------------------------------------*/
-/*                     GENERAL STRUCTURE/PROGRAM OVERVIEW    
- * 
- * The program uses Input Capture to detect pulses from, and navigate to, an 
+/*                     GENERAL STRUCTURE/PROGRAM OVERVIEW
+ *
+ * The program uses Input Capture to detect pulses from, and navigate to, an
  * InfraRed (IR) beacon. The robot uses 2 IR receivers in order to determine
  * whether the beacon is directly ahead, and if not, compare the signal strengths
  * to decide which way to turn.
  * The robot starts by spinning left, in order to sweep the room to locate the
  * beacon. Once the robot detects that the beacon is ahead it proceeds towards it.
- * However, as the robot does not drive perfectly straight, it is necessary to 
- * make small adjustments to its direction. 
+ * However, as the robot does not drive perfectly straight, it is necessary to
+ * make small adjustments to its direction.
  * When the beacon is reached, the robot reads the RFID card. It then rewinds its
- * movements in order to return approximately to its starting position. Once it 
+ * movements in order to return approximately to its starting position. Once it
  * has returned to this location, it displays the 'disarm code', read from the
  * RFID. It also displays a 'bomb' character if the Checksum has been validated
  * correctly. This means that the 'disarm code' has been read correctly.
  *
+ * Scheduler:
+ *
+ * Nothing in the program waits with __delay_ms. Timer2 interrupts every 1ms and
+ * the scheduler (SCHED.c) runs the tasks in the 'tasks' table below when they
+ * are due:
+ *
+ *   sensing    every 5ms   reads RFID bytes, shows the IR readings
+ *   motion     every 1ms   times the movements, records/replays the path
+ *   motors     every 1ms   ramps the motor powers (DCMOTOR.c)
+ *   steering   every 9ms   decides the next movement
+ *   LCD        every 1ms   sends one changed character to the LCD
+ *   LEDs       every 89ms  flashes the LED array
+ *   telemetry  every 25ms  sends a state record on the EUSART (TELEM.c),
+ *                          or the profiler results once the mission is done
+ *   flight     every 1ms   records events, writes the saved log to the EEPROM
+ *   calibration every 1ms  writes a block sent on the serial line to the EEPROM
+ *
+ * Each task has a deadline; a task that starts later than that counts an
+ * overrun in its table entry. Between ticks the CPU idles, with the
+ * peripherals still running, until the next interrupt.
+ *
+ * Profiler:
+ *
+ * With PROFILE set (HEADER.h, a diagnostic build), both interrupts, setMotorPWM, the steering task
+ * and each pass of the task table are timed in instruction cycles with Timer1
+ * (PROF.c), and the ticks at which the beacon was found, the RFID was read and
+ * the robot got home are noted, as is how long the CPU idled in each part of
+ * the mission. When the mission is done the telemetry task sends these
+ * instead of the state records; sim/telemcsv.c prints them.
+ *
+ * Flight recorder:
+ *
+ * The last 16 events (mission phase and movement changes, RFID reads, and a
+ * sample of the IR readings when nothing else has happened for 250ms) are
+ * kept in RAM (FLIGHT.c). They are saved to the data EEPROM when the mission
+ * is over, at the first RFID error, and after a brown-out reset. The saved
+ * log is sent ahead of the telemetry after every reset, or when an 'L' is
+ * received on the serial line; sim/telemcsv.c prints it as a timeline.
+ *
+ * Calibration:
+ *
+ * The motor trims, IR thresholds, baud rate, steering gains, motor slew and
+ * the back-EMF of a motor at full speed come from a block in the data EEPROM, or the defaults if it is missing or
+ * out of range (CAL.c). A PC on the serial line can send a new one, made by
+ * sim/calblock.c, after a 'W' while the robot is looking for the beacon; it
+ * is used straight away and saved. The block in use is sent ahead of the
+ * telemetry after every reset and every new block.
+ *
+ * Trace capture:
+ *
+ * With TRACE set (HEADER.h), the interrupts also queue every IR pulse width
+ * and RFID byte with its tick (TRACE.c), and the telemetry task sends them
+ * instead of the state records. sim/replay.c plays such a recording back
+ * through this program on a PC, so a change can be tried against many real
+ * runs without driving the robot.
+ *
  * Interrupts:
  *
  * 1. High Priority (RFID read)
  *
- * When the RFID card is detected/interrupt flag (serial sends 0x02 header byte),
- * the interrupt reads the 16 bits of data (10 ASCII data bits, 2 Checksum bits)
- * and stores each bit in a separate location in an array. Then, the checksum
- * calculation is performed. All the 10 ASCII data bytes are converted to 5 Hex
- * data bytes, which are then consecutively XOR'd. If the result of this calculation
- * equals the checksum Hex byte (which is also found by converting its 2 respective
- * ASCII bytes), then the data has been read correctly. A variable (rfidFlag) is
- * then set to high. If there was an error when reading the data, this variable
- * is not set to high, and error message is displayed on the LCD. The RFID interrupt
- * flag is then set back to 0.
+ * Each byte received from the RFID reader triggers the interrupt, which only
+ * copies the byte into the serial ring buffer (rxBuffer) and returns. It never
+ * waits for the rest of the frame, so the IR interrupt and the motors are never
+ * held up while a tag is read.
+ *
+ * The frame itself (0x02 header, 10 ASCII data bytes, 2 checksum bytes, CR, LF,
+ * 0x03 end byte) is decoded by the sensing task with rfidPoll() (RFID.c), a
+ * byte at a time as it arrives. Each pair of the 10 ASCII data bytes is
+ * converted to a Hex data byte and XOR'd into the checksum straight away. If
+ * the result equals the checksum Hex byte (which is also found by converting
+ * its 2 respective ASCII bytes), the data has been read correctly. Once
+ * RFID_VOTES frames in a row have been read correctly and agree, a variable
+ * (rfidFlag) is set to high. If there was an error when reading the data (bad
+ * checksum, a byte out of place, or the rest of the frame never arrived), this
+ * variable is not set to high, and an error message is displayed on the LCD.
  *
- * 2. Low Priority (IR read)
+ * 2. Low Priority (IR read, scheduler tick, telemetry)
  *
  * When either the CAP1 or CAP2 (IR receivers) detects a pulse, their interrupt
  * flag is triggered. These are set to low priority, as they are constantly
- * reading. The high byte of CAP(1/2)BUF is stored in a variable called
- * cap(1/2)Buffer. The low byte (CAP1/2BUFL) is ignored, as readings were found
- * to be excessively noisy. When the value is stored, the flag is reset.
+ * reading. The full 16 bit CAP(1/2)BUF is passed to irSample() (IR.c). The raw
+ * readings were found to be excessively noisy, so it takes the median of the
+ * last 3 and smooths that with a moving average, and notes when the reading
+ * was taken. When the value is stored, the flag is reset. Both channels are
+ * then published together, and the tasks take them as a pair with
+ * irSnapshot(), so a decision never mixes readings from different pulses and
+ * the interrupts are never turned off to read them.
+ *
+ * Timer2 also sets a low priority flag every 1ms, which counts sysTicks for
+ * the scheduler.
+ *
+ * The EUSART transmitter (which used to be unused) sends the telemetry. Its
+ * interrupt moves the next byte from the transmit ring buffer (txBuffer) to
+ * TXREG whenever the transmitter is free, and turns itself off when the
+ * buffer is empty.
  *
  *
  * Main Function:
  *
- * 1. Initialisation
- *
- * Ports are reset and initialised. Timer 5 module is set up in order to use
- * Input Capture function (MFM - Chapter 17 PIC18F Datasheet). Interrupts are
- * intialised. Motors are also set up (e.g. PWM). LCD is set up and so is serial
- * communication (for the RFID). It also sends the LCD a custom character
- * (bomb symbol), which is later used for the checksum. The LCD then displays
- * a start screen ('STRUGGLE BOT v1').
- *
- * 2. While(rfidFlag != 1)
- *
- * Until the RFID is read, this 'while' loop iterates. This loop is essentially
- * the routine which navigates the robot to the IR beacon.
- *
- * The 'search' variable in the first 'while' loop indicates whether the IR signal
- * has been detected. It was found through experimentation, that when the signal
- * reads the value '195' in both IR receivers, the beacon is directly ahead of the
- * robot. The 'while' loop tests that this condition is true. Until this condition
- * is met, the robot spins left. The LED array also flashes on and off during this
- * loop, for aesthetic purposes. When both receivers are equal, and read 195, the
- * robot stops spinning, and exits the while loop. The 'search' variable is set to
- * '1'. The robot will now proceed towards the beacon.
- *
- * Along the way it tests certain conditions to ensure it is on the direct path
- * towards the beacon. If both cap1/2Buffer variables read 195, it moves straight.
- * If there is a difference between the IR readings, it moves in the appropriate
- * direction by enacting a slight right/left turn. Due to the characteristics of
- * the IR beacon and IR receivers, occasional anomalous conditions occur and are
- * accounted for by entering a spin to re-establish the location of the beacon.
- * It was found that sometimes these 'anomalies' would change in value, depending
- * on the terrain, and therefore had to be adjusted. The adjustments were made
- * through trial and error, using the LCD display to show readings.
- *
- * In one particular condition, the signal is considered as 'lost'. In this case,
- * the 'search' variable is reset to 0, and the robot now acts like it is searching
- * for the signal again (by spinning left, etc).
+ * Ports are reset and initialised. Motors are set up first (e.g. PWM), then
+ * Timer 5 module is set up in order to use Input Capture function (MFM -
+ * Chapter 17 PIC18F Datasheet). Timer 2 is set up as the 1ms scheduler tick.
+ * Interrupts are intialised. LCD is set up and so is serial communication (for
+ * the RFID). None of these wait: the LCD initialisation is sent in the
+ * background by LCD_Flush(). It also queues a custom character (bomb symbol)
+ * for the LCD, which is later used for the checksum. The LCD then displays a
+ * start screen ('STRUGGLE BOT v1') and the scheduler is started. It never
+ * returns.
+ *
+ * With FAST_BOOT set, the steering task starts the beacon sweep on its first
+ * run, a few ms after reset, while the start screen is still up. The start
+ * screen shows how long after reset the motors were first given power
+ * ('FIRST MOVE'), and is cleared after SPLASH_TICKS. The tick only starts
+ * once everything is set up, so Timer1 is started as soon as the oscillator
+ * is ready and times the set-up, and bootTick is put back by that much. The
+ * C start-up before main(), on the 31kHz reset clock, is not counted.
+ *
+ *
+ * Steering task:
+ *
+ * 1. MISSION_SEARCH
+ *
+ * The robot spins left until the beacon is found. It was found through
+ * experimentation, that when the signal reads the value '195' (high byte) in
+ * both IR receivers, the beacon is directly ahead of the robot. The LED array
+ * also flashes on and off during the search, for aesthetic purposes. When both
+ * receivers have a recent reading in that range, 'BOMB LOCATED' is shown and
+ * the robot starts driving towards the beacon (MISSION_TRACK).
+ *
+ * The sweep (SEARCH.c) also keeps the strongest signal against the heading.
+ * If the robot spins past the beacon without the readings landing in the
+ * range, it turns back to the strongest signal and starts tracking from
+ * there, instead of going all the way round again. After the signal is lost,
+ * the sweep is a short one towards where the beacon was last seen, widening
+ * until it is found.
+ *
+ * 2. MISSION_TRACK
+ *
+ * Every 9ms the steering task tests certain conditions to ensure it is on the
+ * direct path towards the beacon. The difference between the IR readings is
+ * passed to a PID controller (STEER.c), which works out how much to turn, and
+ * the motors are set by steerAhead(): the bigger the difference, the more the
+ * left and right powers are split. The robot no longer zig-zags between a
+ * slight left and a slight right turn. Due to the
+ * characteristics of the IR beacon and IR receivers, occasional anomalous
+ * conditions occur and are accounted for. It was found that sometimes these
+ * 'anomalies' would change in value, depending on the terrain, and therefore had
+ * to be adjusted. The adjustments were made through trial and error, using the
+ * LCD display to show readings.
+ *
+ * In one particular condition, the signal is considered as 'lost'. The signal
+ * is also lost when either receiver has not had a reading for IR_STALE_TICKS.
+ * In this case, the robot goes back to MISSION_SEARCH and spins left again.
  *
  * It was also found that the robot base was prone to veering in one direction,
  * possibly due to the misalingment of the wheels, or slipping of the tracks.
- * Therefore, it was found that this could be compensated for by making the
- * turnSlightRight function to run for 3 times as long as turnSlightLeft.
- *
- * Also, while this loop iterates, each time a new movement occurs, a count
- * variable is incremented. This variable is used to move to a new location in
- * the 'path' array, which records the type of movement
- * For example, if the first movement is fullSpeedAhead, the number '3' is stored
- * in the first location in the 'path' array. If the next movement is turnSlightRight
- * the number '1' is stored in the second location in the 'path' array. And so on.
- *
- * 3. if (rfidFlag == 1)
- *
- * From the high priority interrupt handler for the RFID, a variable, 'rfidFlag'.
- * is set to high. This exits the navigation While loop, and enters this if-statement.
- * First, all unneccessary interrupts are disabled, to prevent interference. The motors
- * are stopped, as the RFID has been read.
- *
- * The robot then enters a for loop in order to return to its start position. In order
- * to do this, the path array is read in reverse, and the movements used to
- * navigate to the beacon are inverted.
- * An iteration variable, 'i', is declared (the size of the path array), in order
- * to move through the array in reverse. As the array is read, the number stored
- * at each location is tested. For example, if a '1' is read in the second location
- * in the path array, (originally a turnSlightRight in forwards) a turnSlightRightBack
- * is called. When the beginning of the path array is reached (end of for loop),
- * the robot should have returned to its start location.
- * The RFID bomb disarm code is then displayed on the LCD, while the LED array flashes.
+ * When every movement lasted 89ms this was compensated for by making
+ * turnSlightRight run for 3 times as long as turnSlightLeft. The integral part
+ * of the controller now takes the veer out. The speed regulator (SPEED.c)
+ * keeps both wheels at the speed their power asks for, so
+ * fullSpeedAhead no longer needs different powers on each side to go straight.
+ *
+ * The motion task records the movements in the path log (PATH.c), which
+ * records the type of movement. For example, if the first movement is
+ * fullSpeedAhead, the number '3' is stored. If the next movement is
+ * turnSlightRight the number '1' is stored after it. And so on. The turns set
+ * by the controller are recorded as the nearest of these: fullSpeedAhead when
+ * smaller than STEER_STRAIGHT, otherwise a slight right or left. Each entry
+ * (segment) also holds how long the movement was driven: the motion task adds
+ * the ticks that have passed every time it runs, so time lost to a late task
+ * is recorded too, rather than every movement being assumed to last 89ms. The
+ * same movement driven again straight after itself stays one segment, so long
+ * straight runs and spins take almost no room.
+ *
+ * 3. MISSION_RETURN
  *
+ * When checkRFID() sees a valid frame, a variable, 'rfidFlag', is set to high.
+ * First, all unneccessary interrupts are disabled, to prevent interference. The
+ * motors are stopped, as the RFID has been read.
+ *
+ * With RETURN_DIRECT set, the robot goes straight home instead. Every tick the
+ * motion task works out where the robot is from the motor powers
+ * (dead reckoning, ODOM.c). When the RFID is read, it works out the heading and
+ * distance back to the start, spins once to face it (or to face directly away
+ * from it if that is less turning, and reverses), then drives a single straight
+ * leg of that length. None of the searching and zig-zagging is repeated.
+ *
+ * With RETURN_DIRECT cleared, the motion task reads the path log in reverse, and the movements used
+ * to navigate to the beacon are inverted (the inverse in the motion table),
+ * each for as long as the segment was driven. For example, if a '1' is read in the path log (originally a
+ * turnSlightRight in forwards) a turnSlightLeftBack is driven. With RETURN_FAST
+ * set, both motors are scaled up until the faster one is at full power and the
+ * time is cut in proportion (applyMotionFast, DCMOTOR.c): the wheels keep the
+ * same ratio, so the robot follows the same track back, only quicker. When the
+ * beginning of the path log is reached, the robot should have returned to its
+ * start location.
+ *
+ * 4. MISSION_DONE
+ *
+ * The RFID bomb disarm code is then displayed on the LCD, while the LED array
+ * flashes. After PARK_TICKS, once the flight log (and any calibration) is
+ * saved and the telemetry has gone, the LEDs are put out and the robot parks:
+ * everything is switched off and the CPU sleeps until it is reset, with the
+ * code still on the LCD.
+ */
 /*----------------------------------------------------------------------------*/
 /*----------------------------------------------------------------------------*/
 
@@ -194,254 +360,501 @@ int startFlag = 0;
 
 /*============================================================================*/
 
+void checkRFID(void);
+void senseTask(void);
+void motionTask(void);
+void steerTask(void);
+void ledTask(void);
+void telemTask(void);
+void flightTask(void);
+void flightEvent(unsigned char type);
+void showCode(void);
+
+// Task table, run in this order every tick
+struct task tasks[] = {
+    // function, period, deadline (ticks), due, overruns
+    {senseTask, 5, 5, 0, 0},
+    {motionTask, 1, 1, 0, 0},
+    {motorRamp, 1, 1, 0, 0},
+#if SPEED
+    {speedTask, 1, 1, 0, 0},
+#endif
+    {steerTask, STEER_TICKS, 2, 0, 0},
+    {LCD_Flush, 1, 1, 0, 0},
+    {ledTask, LED_TICKS, 10, 0, 0},
+    {telemTask, TELEM_TICKS, TELEM_TICKS, 0, 0},
+    {flightTask, 1, 1, 0, 0},
+    {calStep, 1, 1, 0, 0},
+};
+
 
 void main(void) {
 
     OSCCON = 0x72; // Set internal oscillator to 8MHz
     while (!OSCCONbits.IOFS); // Wait for OSC to stablise
+    setTimer1(); // Free running cycle counter: times the start-up below, then the profiler
 
+    calLoad(); // Calibration from the EEPROM (or the defaults), used by everything below
+    flightInit(); // Flight recorder: saves the log of a run cut short by a brown-out
 
     setAllPorts(); // Clear all LAT registers and set all TRIS ports as outputs
     setPorts(); // Sets input ports for CAP1/CAP2
+    initPWM(); // Initialise PWM modules
+    initMotor(); // Function to initialise motor structures
+#if SPEED
+    speedInit(); // Back-EMF readings on AN0/AN1
+#endif
     setTimer5(); // Set up for IC falling-to-rising edge capture
     setInputCapture(); // Initialise input capture module
+    setTimer2(); // 1ms scheduler tick
+    bootTick = sysTicks - profTimer() / SCHED_TICK_CYCLES; // the tick starts now, the times since reset count the start-up too
     setInterrupts(); // Initialise interrupts
-    initPWM(); // Initialise PWM modules
-    initMotor(); // Function to initialise motor structures
-    LCD_Init(); // Initialise the LCD
-    customChars(); // Send LCD the custom characters
+    LCD_Init(); // Initialise the LCD (sent in the background)
+    customChars(); // Queue the custom characters for the LCD
     setupEUSART(); // Initialise serial communication
 
 
-    // Start Screen
+    // Start Screen, cleared after SPLASH_TICKS
     SetLine(1); // Set cursor to line 1 on LCD
     LCD_String("STRUGGLE BOT v1");
-    delay_s(1); // Delay for 1 second
-    clearLCD(); // Clear the LCD display
-
-    /*----------------------------------------------------------------------------*/
-    /*                             FIND BEACON                                    */
-    /*----------------------------------------------------------------------------*/
 
-    while (rfidFlag != 1) {
-
-        //USED FOR DEBUG
-        /*-----------------*/
-        SetLine(1);
-        sprintf(lcdBuffer1, "C1 %d C2 %d       ", cap1Buffer, cap2Buffer);
-        LCD_String(lcdBuffer1);
-        /*-----------------*/
+#if PROFILE
+    profReset(); // timings from here on
+#endif
+    schedRun(tasks, sizeof (tasks) / sizeof (tasks[0])); // never returns
 
+}
 
-        while (search != 1) { // Loop to spin robot round and locate beacon
-            turnLeft(&motorL, &motorR);
 
-            if (startFlag == 1) {
-                /* If this is the first sweep (startFlag is 1), then don't store
-                 * the turn left movement. This prevents the robot from unnecessarily
-                 * spinning on return to its initial orientation */
-            } else {
-                count++; // increment counter
-                path[count] = 4; // store in path movement 'reference code'
-            }
-            LEDout(0); // for debug
-            __delay_ms(89); // movement lasts about 89ms
+/*============================================================================*/
+/*============================================================================*/
+/*                             TASKS                                          */
+/*============================================================================*/
 
-            LEDout(15); // for debug
+/*============================================================================*/
 
-            SetLine(2); // cursor to line 2
-            LCD_String("SEARCHING     "); // for debug - the robot is in the search loop
+//Function to change the movement recorded in the path log, given by its 'reference code'
+void recordMove(char code) {
+    moveCode = code; // the motion task adds the time driven to the path log under this code
+}
 
-            if (cap1Buffer == 195 && cap2Buffer == 195) { // Both sensors found beacon
-                startFlag = 0; /* If this is the first sweep (ie not signal lost), set
-                                * flag to zero, and start storing all movements */
-                search = 1; // Flag changes to exit while loop
-                SetLine(2); // cursor to line 2
-                LCD_String("BOMB LOCATED"); // beacon location is found
-                Stop(&motorL, &motorR); // Stop spinning
-            }
-        }
+//Function to drive a movement, given by its 'reference code' (0 stops)
+void drive(char code) {
+    if (code == moveCode) { // already driving it
+        return;
+    }
+    recordMove(code);
+    applyMotion(code); // the codes are the movements in the table
+}
 
+#if !RETURN_DIRECT
+
+//Function to drive the inverse of a movement, given by its 'reference code', for the ticks it was driven. Returns the ticks to drive it for
+unsigned int driveBack(char code, unsigned int ticks) {
+    moveCode = code;
+#if RETURN_FAST
+    // e.g. turnSlightLeftBack to invert turnSlightRight, at full power for less time
+    return (uint32_t) ticks * applyMotionFast(motions[(unsigned char) code].inverse) / 100;
+#else
+    applyMotion(motions[(unsigned char) code].inverse); // e.g. turnSlightLeftBack to invert turnSlightRight
+    return ticks;
+#endif
+}
 
+#endif
 
-        if (cap1Buffer == 195 && cap2Buffer == 195) { // beacon is ahead
-            fullSpeedAhead(&motorL, &motorR); // move forward
+//Function to stop and start driving back along the path
+void startReturn(void) {
 
-            count++; // increment counter to move to next position in path array
-            path[count] = 3; // store movement 'reference code'
-            __delay_ms(89); // length of movement time
+    PIE3bits.IC1IE = 0; // Turn off the interrupt for CAP1 to prevent issues
+    PIE3bits.IC2QEIE = 0; // Turn off the interrupt for CAP2 to prevent issues
+    PIE1bits.RCIE = 0; // Turn off the interrupt for RFID to prevent further reads
 
-        } else {
+    if (lcdFlag == 0) {
+        //clears LCD once in the whole code
+        clearLCD();
+        lcdFlag = 1;
+    }
 
-            if (cap1Buffer > cap2Buffer) { // difference in readings of IR
+    SetLine(1); // cursor to line 1
+#if RETURN_DIRECT
+    LCD_String("RETURNING");
+#else
+    LCD_String("REVERSING");
+#endif
+
+    drive(0); // stop motors, as robot is next to beacon
+
+#if RETURN_DIRECT
+    odomHome(&homeBearing, &homeDistance);
+    if ((int32_t) (homeBearing - odomHeading) > (int32_t) ODOM_ANGLE(90)
+            || (int32_t) (homeBearing - odomHeading) < -(int32_t) ODOM_ANGLE(90)) {
+        // home is behind: face directly away from it and reverse, it is less turning
+        homeBearing += ODOM_ANGLE(180);
+        returnBack = 1;
+    }
+    returnPhase = RETURN_TURN;
+#else
+    pathRewind(); // read the path log backwards from here
+    replayLeft = 0;
+#endif
+    mission = MISSION_RETURN;
+}
 
-                turnSlightRight(&motorL, &motorR); // make adjustment
+//Function to turn towards home, then drive the single straight leg to it
+void returnHome(void) {
+    int32_t error;
+    int32_t travelled;
+
+    if (returnPhase == RETURN_TURN) {
+        error = (int32_t) (homeBearing - odomHeading);
+
+        if (error > -(int32_t) RETURN_AIM && error < (int32_t) RETURN_AIM) {
+            returnStart = odomTravel;
+            returnPhase = RETURN_DRIVE;
+            moveCode = returnBack ? MOVE_BACK : MOVE_AHEAD;
+            applyMotion(moveCode);
+        } else if (error > 0 && moveCode != MOVE_SPIN_RIGHT) {
+            moveCode = MOVE_SPIN_RIGHT;
+            applyMotion(MOVE_SPIN_RIGHT); // anticlockwise, as m_L is the right motor
+        } else if (error < 0 && moveCode != MOVE_SPIN_LEFT) {
+            moveCode = MOVE_SPIN_LEFT;
+            applyMotion(MOVE_SPIN_LEFT); // clockwise
+        }
 
-                count++; // increment counter to move to next position in path array
-                path[count] = 1; // store movement 'reference code'
+    } else {
+        travelled = odomTravel - returnStart;
+        if (travelled < 0) { // reversing
+            travelled = -travelled;
+        }
+        if (travelled >= homeDistance) { // back at the start
+            showCode();
+        }
+    }
+}
 
-                __delay_ms(89); // movement time is slightly longer, for tweaking
-                __delay_ms(89);
-                __delay_ms(89);
+//Function to stop and show the disarm code
+void showCode(void) {
 
+    applyMotion(MOVE_STOP); // ensure motors are stopped
+    moveCode = 0;
+    PROF_MARK(PROF_MARK_HOME);
 
-            }
-            if (cap2Buffer > cap1Buffer) { // difference in readings of IR
+    if (lcdFlag == 0) { // as before
+        //clears LCD once in the whole code
+        clearLCD();
+        lcdFlag = 1;
+    }
 
+    SetLine(1); // Set the cursor to the LCD's first line
+    LCD_String("DISARM CODE: "); // The line underneath is the code
 
-                turnSlightLeft(&motorL, &motorR); // make adjustment
+    // DISPLAY THE CODE
 
-                count++; // increment counter to move to next position in path array
-                path[count] = 2; // store movement 'reference code'
-                __delay_ms(89);
+    SetLine(2); // Set the cursor to the LCD's second line
+    for (unsigned char j = 0; j < RFID_TAG_BYTES; j++) {
+        /* Iterate through the confirmed tag, showing each of its 5 bytes
+         * as 2 hex digits (i.e. the code), whatever case the reader sent. */
 
+        LCD_Hex(rfidTag[j], 2); // Display byte by byte
+    }
 
-            }
-            if (cap2Buffer == cap1Buffer && cap1Buffer != 195 && cap2Buffer != 195) {
-                // anomalous condition (see above)
+    // DISPLAY THE CHECKSUM LOGO
 
-                fullSpeedAhead(&motorL, &motorR);
+    LCD_String(" "); // Space
+    LCD_Char(0x01); // Send the bomb custom character
+    LCD_String("CS"); // "CS" stands for "checksum"
 
-                count++;
-                path[count] = 3;
-                __delay_ms(89);
+    doneTick = schedTicks();
+    mission = MISSION_DONE;
+}
 
-            }
-            if (cap1Buffer == 0 && cap2Buffer <= 5) {
-                // anomalous condition - presented itself when signal was lost
+//Sensing task: RFID bytes and the IR readings
+void senseTask(void) {
 
-                search = 0; // debug corrections - this occurs when signal lost
-                // this causes re-entry to earlier while loop
-                // note that this time, the startFlag is tripped and the movement
-                // will be recorded
+    if (mission != MISSION_SEARCH && mission != MISSION_TRACK) {
+        return;
+    }
 
+    checkRFID(); // pick up any RFID bytes received since the last run
+
+    if (splash) {
+        if ((uint16_t) (schedTicks() - bootTick) < SPLASH_TICKS) {
+            if (motorFirstTick != MOTOR_NOT_MOVED && !bootShown) {
+                // time from reset to first motion (from main, see bootTick)
+                bootShown = 1;
+                SetLine(2);
+                LCD_String("FIRST MOVE");
+                LCD_Unsigned((uint16_t) (motorFirstTick - bootTick), 4);
+                LCD_String("ms");
             }
-
+            return;
         }
-
-
-
-
+        clearLCD(); // start screen over
+        splash = 0;
     }
 
+    //USED FOR DEBUG
+    /*-----------------*/
+    struct ir_reading cap1, cap2;
 
+    irSnapshot(&cap1, &cap2);
+    if ((unsigned char) (cap1.samples + cap2.samples) != shownSamples) { // new reading
+        shownSamples = cap1.samples + cap2.samples;
+        SetLine(1);
+        LCD_String("1:");
+        LCD_Unsigned(cap1.value, 5);
+        LCD_String(" 2:");
+        LCD_Unsigned(cap2.value, 5);
+        LCD_Char(' ');
+    }
+    /*-----------------*/
+}
 
+//Motion task: times the movements and tracks the position, recording them on the way out and returning on the way back
+void motionTask(void) {
+    uint16_t now = schedTicks();
+    unsigned char elapsed = (uint16_t) (now - moveLastTick); // normally 1, more if the task ran late
 
-    /*----------------------------------------------------------------------------*/
-    /*             BEACON FOUND; RFID FLAGGED                                     */
-    /*----------------------------------------------------------------------------*/
-
-    if (rfidFlag == 1) { // set to high when RFID is read
-
-
-        PIE3bits.IC1IE = 0; // Turn off the interrupt for CAP1 to prevent issues
-        PIE3bits.IC2QEIE = 0; // Turn off the interrupt for CAP2 to prevent issues
-        PIE1bits.RCIE = 0; // Turn off the interrupt for RFID to prevent further reads
-
-
+    moveLastTick = now;
+    odomStep(elapsed); // dead reckoning, at the powers set since the last run
 
-        if (lcdFlag == 0) {
-            //clears LCD once in the whole code
-            clearLCD();
-            lcdFlag = 1;
+#if RETURN_DIRECT
+    if (mission == MISSION_RETURN) {
+        returnHome();
+    }
+#else
+    if (mission == MISSION_SEARCH || mission == MISSION_TRACK) {
 
-            __delay_ms(5); // ensure that the LCD is cleared properly
+        if (moveCode == 0) {
+            return;
         }
 
+        if (moveCode == 4 && startFlag == 1) {
+            /* If this is the first sweep (startFlag is 1), then don't store
+             * the turn left movement. This prevents the robot from unnecessarily
+             * spinning on return to its initial orientation */
+        } else {
+            pathAdd(moveCode, elapsed); // store movement 'reference code' and the time driven
+        }
 
-        SetLine(1); // cursor to line 1
-        LCD_String("REVERSING");
-
-
-        Stop(&motorL, &motorR); // stop motors, as robot is next to beacon
-        int i = sizeof (path); // iterative variable to count backwards through array
-        while (i != 0) { // while array position is not at the beginning
-
+    } else if (mission == MISSION_RETURN) {
+        char code;
+        unsigned int ticks;
 
+        replayLeft -= elapsed;
+        while (replayLeft <= 0) { // segment finished, start the one before it
+            code = pathPrev(&ticks);
+            if (code == 0) { // back at the beginning of the path log
+                showCode();
+                return;
+            }
 
-            int x;
-            x = path[i];
-            if (x == 1) { // is the movement at position 'i' referred to as '1'?
-                turnSlightLeftBack(&motorL, &motorR); // function to invert turnSlightLeft
-                __delay_ms(89);
+            replayLeft += driveBack(code, ticks); // any lateness comes off the next segment
+        }
+    }
+#endif
+}
 
+//Steering task: decides which movement to drive
+void steerTask(void) {
+    struct ir_reading cap1, cap2;
+    char fresh;
+    unsigned char code;
 
-                LEDout(1); // for debug
+    PROF_BEGIN(PROF_STEER);
+    irSnapshot(&cap1, &cap2); // every decision below is made on the same pair
+    fresh = irFresh(&cap1) && irFresh(&cap2);
 
-            } else if (x == 2) {
-                turnSlightRightBack(&motorL, &motorR);
-                __delay_ms(89); // length of time is identical to the inverse of this movement
-                __delay_ms(89); // (i.e. turnSlightRightBack)
-                __delay_ms(89);
+    switch (mission) {
 
+        case MISSION_START:
+#if !FAST_BOOT
+            if ((uint16_t) (schedTicks() - bootTick) < SPLASH_TICKS) {
+                break;
+            }
+            clearLCD(); // Clear the LCD display
+            splash = 0;
+#endif
+            mission = MISSION_SEARCH; // with FAST_BOOT the sensing task clears the start screen
+            searchStart(0); // a whole turn, the beacon has not been seen yet
+            break;
+
+            /*----------------------------------------------------------------*/
+            /*                         FIND BEACON                            */
+            /*----------------------------------------------------------------*/
+
+        case MISSION_SEARCH:
+            if (rfidFlag == 1) {
+                startReturn();
+                break;
+            }
 
-                LEDout(2); // for debug
+            if (!splash) {
+                SetLine(2); // cursor to line 2
+                LCD_String("SEARCHING     "); // for debug - the robot is searching
+            }
 
-            } else if (x == 3) {
-                fullSpeedBack(&motorL, &motorR);
-                __delay_ms(89);
+            code = searchUpdate(cap1.value, cap2.value, fresh); // sweep, turning back to the strongest signal
 
+            if (code != MOVE_STOP && (!fresh || cap1.value < cal.irAheadLow || cap1.value > cal.irAheadHigh
+                    || cap2.value < cal.irAheadLow || cap2.value > cal.irAheadHigh)) {
+                drive(code);
+                break;
+            }
 
-                LEDout(3); // for debug
+            // Both sensors found beacon, or the robot is facing the strongest signal
+            startFlag = 0; /* If this is the first sweep (ie not signal lost), set
+                            * flag to zero, and start storing all movements */
+            SetLine(2); // cursor to line 2
+            LCD_String("BOMB LOCATED"); // beacon location is found
+            PROF_MARK(PROF_MARK_BEACON); // the first time only
+            mission = MISSION_TRACK; // and head straight for it
+            steerReset(); // the controller starts afresh each time
+            /* FALLTHROUGH */
+
+        case MISSION_TRACK:
+            if (rfidFlag == 1) {
+                startReturn();
+                break;
+            }
 
-            } else if (x == 4) {
-                turnRight(&motorL, &motorR);
-                __delay_ms(89);
+            if (!fresh || (cap1.value < cal.irLostCap1 && cap2.value < cal.irLostCap2)) {
+                // no recent readings, or the anomalous condition that presented
+                // itself when signal was lost
+                // note that this time, the startFlag is tripped and the movement
+                // will be recorded. The sweep starts towards where the beacon
+                // was last seen
+                mission = MISSION_SEARCH;
+                drive(searchStart(steerTurn));
 
-                LEDout(4); // for debug
+            } else {
+                // steer by the difference in readings of IR. Equal readings
+                // (beacon ahead, or the anomalous condition where both are
+                // equal but not 195) drive straight
+                steerTurn = steerUpdate(cap1.value, cap2.value);
+                steerAhead(&motorL, &motorR, steerTurn);
+                searchSeen(); // remembered in case the signal is lost
+
+                if (steerTurn >= STEER_STRAIGHT) {
+                    recordMove(1); // recorded as turnSlightRight
+                } else if (steerTurn <= -STEER_STRAIGHT) {
+                    recordMove(2); // recorded as turnSlightLeft
+                } else {
+                    recordMove(3); // recorded as fullSpeedAhead
+                }
             }
+            break;
 
-            i--; // decrement counter to move to next position in path array
+        default:
+            // MISSION_RETURN and MISSION_DONE are driven by the motion task
+            break;
+    }
+    PROF_END(PROF_STEER);
+}
 
+//Telemetry task: sends the state of the robot for analysis on a PC
+void telemTask(void) {
+    struct telem_state t;
+    struct ir_reading cap1, cap2;
 
+    if (calReportNext()) { // the calibration in use goes first (after a reset or a new block)
+        return;
+    }
+    if (flightDumpNext()) { // then the flight recorder log (after a reset or when asked)
+        return;
+    }
+#if TRACE
+    if (traceSend()) { // the IR and RFID input, when there is any, instead of the state
+        return;
+    }
+#endif
+
+#if PROFILE
+    if (mission == MISSION_DONE) {
+        // the profiler results instead, over and over, one record every
+        // other run as a probe record takes longer than TELEM_TICKS to send
+        profSlow = !profSlow;
+        if (profSlow) {
+            return;
         }
-
-
-        /*-------------------------------------------*/
-        // when loop has exited the RFID disarm code is displayed:
-
-
-        if (lcdFlag == 0) { // as before
-            //clears LCD once in the whole code
-            clearLCD();
-            lcdFlag = 1;
-
-            __delay_ms(5);
+        if (profNext < PROF_PROBES) {
+            profNext += telemProfile(profNext); // tried again next time if dropped
+        } else if (profNext == PROF_PROBES) {
+            profNext += telemMarks();
+        } else if (telemPower()) {
+            profNext = 0;
         }
+        return;
+    }
+#endif
+
+    irSnapshot(&cap1, &cap2);
+
+    t.ticks = schedTicks();
+    t.cap1 = cap1.value;
+    t.cap2 = cap2.value;
+    t.move = moveCode;
+    t.right = motorL.direction ? -motorL.power : motorL.power; // m_L is the right motor
+    t.left = motorR.direction ? -motorR.power : motorR.power;
+#if RETURN_DIRECT
+    t.pathRuns = 0; // no path log
+    t.pathScale = 0;
+#else
+    t.pathRuns = pathLength;
+    t.pathScale = pathScale;
+#endif
+    t.mission = mission;
+    telemState(&t); // never waits, dropped if the buffer is full
+}
 
-        SetLine(1); // Set the cursor to the LCD's first line
-        LCD_String("DISARM CODE: "); // The line underneath is the code
+//Function to add an event to the flight recorder, with the IR readings and what the robot is doing
+void flightEvent(unsigned char type) {
+    struct ir_reading cap1, cap2;
 
-        // DISPLAY THE CODE
+    irSnapshot(&cap1, &cap2);
+    flightRecord(type, cap1.value >> 8, cap2.value >> 8, moveCode, mission);
+    flightLast = schedTicks();
+}
 
-        SetLine(2); // Set the cursor to the LCD's second line
-        for (int j = 1; j <= 10; j++) {
-            /* Iterate through the stored data array, showing only the 10
-             * ASCII data bytes (i.e. the code). */
+//Flight recorder task: records changes of mission and movement, saves the log when the mission is over
+void flightTask(void) {
 
-            SendLCD(rfidData[j], 1); // Diplay byte by byte
+    if (mission != flightMission) {
+        flightMission = mission;
+        flightEvent(FLIGHT_MISSION);
+        if (mission == MISSION_DONE) {
+            flightCommit(FLIGHT_COMMIT_DONE);
         }
+    } else if (moveCode != flightMove && mission != MISSION_TRACK) {
+        // not while tracking: the steering changes the recorded movement
+        // every few runs, the samples show it instead
+        flightMove = moveCode;
+        flightEvent(FLIGHT_MOVE);
+    } else if ((uint16_t) (schedTicks() - flightLast) >= FLIGHT_SAMPLE_TICKS) { // nothing else for a while
+        flightEvent(FLIGHT_SAMPLE);
+    }
 
-        // DISPLAY THE CHECKSUM LOGO
-
-        LCD_String(" "); // Space
-        SendLCD(0x01, 1); // Send the bomb custom character
-        LCD_String("CS"); // "CS" stands for "checksum"
+    flightStep(); // EEPROM writes, one at a time as each finishes
+}
 
+//LED task: flashes the LED array
+void ledTask(void) {
 
-        Stop(&motorL, &motorR); // ensure motors are stopped
+    ledState = !ledState;
 
-        while (1) { // flash LED array indefinitely (FOR AESTHETICS)
-            LEDout(15);
-            __delay_ms(89);
+    if (mission == MISSION_SEARCH) {
+        LEDout(ledState ? 15 : 0); // for debug
+    } else if (mission == MISSION_RETURN) {
+        LEDout(moveCode); // for debug - movement being replayed
+    } else if (mission == MISSION_DONE) {
+        LEDout(ledState ? 15 : 0); // flash LED array (FOR AESTHETICS)
+        if ((uint16_t) (schedTicks() - doneTick) >= PARK_TICKS && !flightSaving() && !calSaving() && txTail == txHead && TXSTAbits.TRMT) {
+            // the log is saved and the telemetry sent: park, the code stays on the LCD
             LEDout(0);
-            __delay_ms(89);
+            sleepForever();
         }
-
-
     }
-
-
 }
 
 
@@ -454,83 +867,66 @@ void main(void) {
 
 void interrupt high_priority RFIDinterrupt() {
 
-    if (PIR1bits.RCIF) {
-
-        /* Function reads RFID card data into an array
-         and then displays the disarm code in the LCD screen */
-
-        // Variables for serial communication
-        int i = 1; // Iteration variable
-
-
-        rfidData[0] = getCharSerial(); // Read the first byte
-
-        if (rfidData[0] == 0x02) { // If the header byte is detected, proceed
-            rfidData[i] = getCharSerial(); // Store the next byte in the array
-
-            while (rfidData[i] != 0x03) {
-                /* Until the end byte is received, store consecutive bytes
-                 * in the buf array */
-
-                i++; // increase the counter to move to the next location in array
-
-                rfidData[i] = getCharSerial(); // Store the byte read from the RFID
-
-            }
-
+    /* Moves the received byte into the serial ring buffer and returns straight
+     * away. The frame is put together by rfidPoll() from the sensing task. */
 
-            /*---------- CHECKSUM CALCULATION ---------*/
+    PROF_BEGIN(PROF_RFID_ISR);
 
+    if (PIR1bits.RCIF) {
 
-            /* The following is the checksum calculation to ensure that the data
-             * has been read correctly from the RFID. This is done by converting
-             * each pair of the 10 ASCII data bytes into a single hex byte
-             * (using the asciiHexBinary function), and then XORing them all
-             * together. If the data has been read correctly, the result should
-             * equal the single hexadecimal of the checksum bytes read at
-             * location 12 and 13 of the 16 bits of data read from the RFID.*/
-
-            char hexArray[5]; // Stores the converted array of hex data bytes
-
-            for (int k = 1; k <= 10; k++) { // Iterates through the buffer data array
-
-                for (int l = 0; l <= 5; l++) { // Iterates through the hexArray
-                    hexArray[l] = asciiHexBinary(rfidData[k], rfidData[k + 1]); 
-
-                }
+        unsigned char byte = RCREG; // Reading RCREG clears the flag
+        unsigned char next = (rxHead + 1) & (RX_BUFFER_SIZE - 1);
 
+        TRACE_EVENT(TRACE_RX, byte);
 
-            }
+        if (next != rxTail) { // Store the byte unless the buffer is full
+            rxBuffer[rxHead] = byte;
+            rxHead = next;
+        } else {
+            rxDropped++;
+        }
 
-            // Store checksum data byte
-            char checksumBytes = asciiHexBinary(rfidData[11], rfidData[12]);
+        if (RCSTAbits.OERR) { // Receiver overrun stops reception until CREN is toggled
+            RCSTAbits.CREN = 0;
+            RCSTAbits.CREN = 1;
+        }
 
-            // Store checksum XOR values
-            char checksumHolder = hexArray[1] ^ hexArray[2];
+    }
 
-            for (int a = 3; a <= 5; a++) { // consecutively XORs the data bytes
-                checksumHolder ^= hexArray[a];
+    PROF_END(PROF_RFID_ISR);
+}
 
-            }
 
+/*============================================================================*/
+/*============================================================================*/
+/*                             RFID FRAMES                                    */
+/*============================================================================*/
 
-            if (checksumBytes == checksumHolder) { // If the result matches the databyte
-                TRISCbits.RC7 = 0; // turn off the RFID input pin
-                rfidFlag = 1;
+/*============================================================================*/
 
+void checkRFID(void) {
 
+    /* Passes any received bytes to the RFID frame decoder. Sets rfidFlag when
+     * enough frames with a valid checksum have agreed on the tag. */
 
-            } else {
+    char result = rfidPoll();
 
-                // DISPLAY THE ERROR MESSAGE
-                SetLine(1);
-                LCD_String("read error."); // The checksum doesn't work; an error occured.
-            }
+    if (result == RFID_OK) {
+        TRISCbits.RC7 = 0; // turn off the RFID input pin
+        rfidFlag = 1;
+        PROF_MARK(PROF_MARK_RFID);
+        flightEvent(FLIGHT_RFID_OK);
 
+    } else if (result == RFID_ERROR) {
+        flightEvent(FLIGHT_RFID_ERROR);
+        if (!flightRfidSaved) { // what led up to the first bad frame
+            flightCommit(FLIGHT_COMMIT_RFID);
+            flightRfidSaved = 1;
         }
 
-        PIR1bits.RCIF = 0; // Reset the flag to ZERO
-
+        // DISPLAY THE ERROR MESSAGE
+        SetLine(1);
+        LCD_String("read error."); // The checksum doesn't work; an error occured.
     }
 
 }
@@ -545,13 +941,17 @@ void interrupt high_priority RFIDinterrupt() {
 
 void interrupt low_priority IRinterrupt() {
 
-    /* The low priority interrupt handles only the readings from the MFM module
+    /* The low priority interrupt handles the readings from the MFM module
      * - Input Capture (Chapter 17 of PIC18F Data Sheet). It stores the values
-     * read by the IR receivers. */
+     * read by the IR receivers. It also counts the Timer2 scheduler tick and
+     * sends the telemetry bytes. */
+
+    PROF_BEGIN(PROF_IR_ISR);
 
     if (PIR3bits.IC1IF) { // CAP1 interrupt triggered when pulse measured
 
-        cap1Buffer = CAP1BUFH; // Store only the high byte of CAP1BUF in a variable
+        irSample(0, CAP1BUF); // Filter the full 16 bit reading
+        TRACE_EVENT(TRACE_CAP1, CAP1BUF);
 
         PIR3bits.IC1IF = 0; // Reset the flag
 
@@ -559,11 +959,31 @@ void interrupt low_priority IRinterrupt() {
 
     if (PIR3bits.IC2QEIF) { // CAP2 interrupt triggered when pulse measured
 
-        cap2Buffer = CAP2BUFH; // Store only the high byte of CAP2BUF in a variable
+        irSample(1, CAP2BUF); // Filter the full 16 bit reading
+        TRACE_EVENT(TRACE_CAP2, CAP2BUF);
 
         PIR3bits.IC2QEIF = 0; // Reset the flag
 
     }
 
+    if (PIR1bits.TMR2IF) { // 1ms tick
 
-}
\ No newline at end of file
+        sysTicks++; // The scheduler runs the tasks that are due
+
+        PIR1bits.TMR2IF = 0; // Reset the flag
+
+    }
+
+    if (PIE1bits.TXIE && PIR1bits.TXIF) { // Transmitter free (telemetry)
+
+        if (txTail != txHead) {
+            TXREG = txBuffer[txTail]; // Writing TXREG clears the flag
+            txTail = (txTail + 1) & (TX_BUFFER_SIZE - 1);
+        } else {
+            PIE1bits.TXIE = 0; // Nothing left to send
+        }
+
+    }
+
+    PROF_END(PROF_IR_ISR);
+}
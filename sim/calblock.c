@@ -0,0 +1,61 @@
+/* ------------------------------------------------------------------------ *
+ * StruggleBot calibration writer.                                          *
+ *                                                                          *
+ * Makes the bytes that retune a robot without reflashing it: CAL_WRITE_BYTE *
+ * and a calibration block (calimage.c) with the values given, the rest     *
+ * the compiled defaults. Sent on the serial line in place of the RFID      *
+ * reader while the robot is looking for the beacon, the block is used      *
+ * straight away and saved in the data EEPROM (CAL.c):                      *
+ *                                                                          *
+ *   calblock [-x | -l] [name=value ...]                                    *
+ *                                                                          *
+ *   stty -F /dev/ttyUSB0 9600 raw                                          *
+ *   calblock kp=80 right_trim=-2 > /dev/ttyUSB0                            *
+ *                                                                          *
+ * -x writes the bytes in hex on one line instead, for an rx line in a      *
+ * scenario; -l lists the values in the block. The robot answers with a    *
+ * TELEM_CAL record, which telemcsv prints ("written" or "rejected").       *
+ * ------------------------------------------------------------------------ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "sim.h"
+
+int main(int argc, char **argv) {
+    unsigned char out[1 + SIM_CAL_BYTES];
+    char settings[512] = "", text[512];
+    int opt, hex = 0, list = 0;
+
+    while ((opt = getopt(argc, argv, "xl")) != -1) {
+        switch (opt) {
+            case 'x': hex = 1; break;
+            case 'l': list = 1; break;
+            default:
+                fprintf(stderr, "usage: calblock [-x | -l] [name=value ...]\n");
+                return 1;
+        }
+    }
+    for (int i = optind; i < argc; i++) {
+        strncat(settings, argv[i], sizeof settings - strlen(settings) - 2);
+        strcat(settings, " ");
+    }
+
+    out[0] = SIM_CAL_WRITE_BYTE;
+    if (!sim_cal_block(out + 1, settings))
+        return 1;
+
+    if (list) {
+        sim_cal_text(text, sizeof text, out + 1);
+        printf("%s\n", text);
+    } else if (hex) {
+        for (int i = 0; i < (int) sizeof out; i++)
+            printf("%s%02X", i ? " " : "", out[i]);
+        printf("\n");
+    } else if (fwrite(out, 1, sizeof out, stdout) != sizeof out) {
+        perror("calblock");
+        return 1;
+    }
+    return 0;
+}
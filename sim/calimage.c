@@ -0,0 +1,122 @@
+/* ------------------------------------------------------------------------ *
+ * StruggleBot calibration blocks.                                          *
+ *                                                                          *
+ * Makes and reads the calibration block the firmware keeps in its data    *
+ * EEPROM (CAL.c), laid out as on the robot: CAL_BYTES bytes, 16 bit values *
+ * low byte first, CRC-16 (CCITT) last. The values are given by name:       *
+ *                                                                          *
+ *   right_trim left_trim ir_ahead_low ir_ahead_high ir_lost_cap1           *
+ *   ir_lost_cap2 spbrg slew kp ki kd emf_full                              *
+ *                                                                          *
+ * and anything not given is the compiled default. Values outside the       *
+ * firmware's CAL_ limits are refused here, as the robot would refuse the   *
+ * block; it also wants the lost thresholds below ir_ahead_low, which is    *
+ * left to it (the report then says "rejected").                            *
+ *                                                                          *
+ * Used by calblock.c, the scenarios (cal) and telemcsv.c.                  *
+ * ------------------------------------------------------------------------ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim.h"
+
+// keep in step with the CAL section of HEADER.h and calPack() in CAL.c
+#define CAL_VERSION     3
+#define CAL_CRC_AT      (SIM_CAL_BYTES - 2)
+
+struct field {
+    const char *name;
+    int at, bytes, isSigned;
+    long value, min, max;               // default and CAL_ limits
+};
+
+static const struct field fields[] = {
+    {"right_trim",      1, 1, 1, 0, -20, 20},
+    {"left_trim",       2, 1, 1, 0, -20, 20},
+    {"ir_ahead_low",    3, 2, 0, 195 << 8, 0, 65535},
+    {"ir_ahead_high",   5, 2, 0, (196 << 8) - 1, 0, 65535},
+    {"ir_lost_cap1",    7, 2, 0, 1 << 8, 0, 65535},
+    {"ir_lost_cap2",    9, 2, 0, 6 << 8, 0, 65535},
+    {"spbrg",          11, 1, 0, 205, 197, 217},
+    {"slew",           12, 1, 0, 2, 1, 20},
+    {"kp",             13, 2, 1, 64, 0, 1024},
+    {"ki",             15, 2, 1, 2, 0, 1024},
+    {"kd",             17, 2, 1, 32, 0, 1024},
+    {"emf_full",       19, 2, 0, 800, 100, 1000},
+};
+#define FIELDS (int) (sizeof fields / sizeof fields[0])
+
+static unsigned int crc16(const unsigned char *b) {
+    unsigned int crc = 0xFFFF;
+
+    for (int i = 0; i < CAL_CRC_AT; i++) {
+        crc ^= b[i] << 8;
+        for (int bit = 0; bit < 8; bit++)
+            crc = (crc & 0x8000 ? crc << 1 ^ 0x1021 : crc << 1) & 0xFFFF;
+    }
+    return crc;
+}
+
+static void put(unsigned char *block, const struct field *f, long value) {
+    block[f->at] = value;
+    if (f->bytes == 2)
+        block[f->at + 1] = value >> 8;
+}
+
+static long get(const unsigned char *block, const struct field *f) {
+    long value = block[f->at];
+
+    if (f->bytes == 2)
+        value |= block[f->at + 1] << 8;
+    if (f->isSigned && value >= 1L << (8 * f->bytes - 1))
+        value -= 1L << (8 * f->bytes);
+    return value;
+}
+
+int sim_cal_block(unsigned char block[SIM_CAL_BYTES], const char *settings) {
+    char name[32];
+    int used, i;
+    long value;
+    unsigned int crc;
+
+    memset(block, 0, SIM_CAL_BYTES);
+    block[0] = CAL_VERSION;
+    for (i = 0; i < FIELDS; i++)
+        put(block, &fields[i], fields[i].value);
+
+    while (sscanf(settings, " %31[^= ]=%li%n", name, &value, &used) == 2) {
+        for (i = 0; i < FIELDS && strcmp(fields[i].name, name); i++)
+            ;
+        if (i == FIELDS) {
+            fprintf(stderr, "calibration: no value called '%s'\n", name);
+            return 0;
+        }
+        if (value < fields[i].min || value > fields[i].max) {
+            fprintf(stderr, "calibration: %s must be %ld to %ld\n", name, fields[i].min, fields[i].max);
+            return 0;
+        }
+        put(block, &fields[i], value);
+        settings += used;
+    }
+    if (sscanf(settings, " %31s", name) == 1) {
+        fprintf(stderr, "calibration: '%s' is not name=value\n", name);
+        return 0;
+    }
+
+    crc = crc16(block);
+    block[CAL_CRC_AT] = crc;
+    block[CAL_CRC_AT + 1] = crc >> 8;
+    return 1;
+}
+
+void sim_cal_text(char *out, int size, const unsigned char *block) {
+    int n = 0;
+
+    out[0] = 0;
+    for (int i = 0; i < FIELDS && n < size; i++)
+        n += snprintf(out + n, size - n, "%s%s=%ld", i ? " " : "", fields[i].name, get(block, &fields[i]));
+    if (n < size && (block[0] != CAL_VERSION || (unsigned int) (block[CAL_CRC_AT] | block[CAL_CRC_AT + 1] << 8) != crc16(block)))
+        snprintf(out + n, size - n, " (version %u, bad CRC)", block[0]);
+}
@@ -0,0 +1,261 @@
+#!/usr/bin/env python3
+#
+# Static RAM and compiled stack estimate for the firmware on the PIC18F4331.
+#
+# The host build is no guide to what the firmware needs on the part: every
+# int and pointer is twice the size or more, and GCC keeps locals on a real
+# stack. This reads the firmware objects built for the host (with -O0 -g
+# -ffunction-sections, see the memcheck target in the Makefile) and works
+# the figures out again with XC8's type sizes:
+#
+#   static RAM      every variable with a fixed address that is not const
+#                   (XC8 puts const objects in program memory), no padding
+#   compiled stack  XC8 gives each function's parameters, locals and return
+#                   value a fixed place, shared with the functions it can
+#                   never be live at the same time as. The space needed is
+#                   the heaviest call chain from main, plus the heaviest
+#                   from each interrupt (they can come in at any point).
+#                   The call graph comes from the relocations in each
+#                   function's section; an indirect call (the task table)
+#                   can reach every function whose address is taken.
+#
+# It is an estimate: XC8's own temporaries, its library routines (32-bit
+# multiply and divide) and the interrupt context save are not counted, so
+# RESERVE bytes are kept back for them. The memory summary of the XC8 build
+# (Program space / Data space used) is the real figure and has the last word.
+#
+#     memcheck.py [-v] objects...
+#
+# Exits 1 if the estimate does not fit in RAM_SIZE - RESERVE.
+
+import re
+import subprocess
+import sys
+
+RAM_SIZE = 768          # PIC18F4331 general purpose RAM, bytes
+RESERVE = 48            # kept back for what is not counted (see above)
+POINTER = 2             # data, const and function pointers (8KB of program memory)
+ROOTS = ['firmware_main', 'RFIDinterrupt', 'IRinterrupt']  # main() is renamed for the host
+
+BASE = {
+    'char': 1, 'signed char': 1, 'unsigned char': 1, '_Bool': 1,
+    'short int': 2, 'short unsigned int': 2, 'int': 2, 'unsigned int': 2,
+    'long int': 4, 'long unsigned int': 4,
+    'long long int': 8, 'long long unsigned int': 8,
+    'float': 4, 'double': 4,
+}
+FIXED = {'int8_t': 1, 'uint8_t': 1, 'int16_t': 2, 'uint16_t': 2, 'int32_t': 4, 'uint32_t': 4}
+
+ENTRY = re.compile(r'^\s*<(\d+)><([0-9a-f]+)>: Abbrev Number: \d+ \((\w+)\)')
+ATTR = re.compile(r'^\s*<[0-9a-f]+>\s+(DW_AT_\w+)\s*: (.*)$')
+REF = re.compile(r'<0x([0-9a-f]+)>')
+
+
+def dwarf(path):
+    """The DIEs of one object: offset -> [tag, depth, attributes, parent]."""
+    out = subprocess.run(['readelf', '--debug-dump=info', path],
+                         capture_output=True, text=True, check=True).stdout
+    dies, stack, die = {}, [], None
+    for line in out.splitlines():
+        m = ENTRY.match(line)
+        if m:
+            depth, off = int(m.group(1)), int(m.group(2), 16)
+            del stack[depth:]
+            die = [m.group(3), depth, {}, stack[-1] if stack else None]
+            dies[off] = die
+            stack.append(off)
+            continue
+        m = ATTR.match(line)
+        if m and die is not None:
+            die[2][m.group(1)] = m.group(2).strip()
+    return dies
+
+
+def name_of(value):
+    return value.split(': ')[-1].strip()
+
+
+def number(value):
+    return int(value.split()[-1], 0)
+
+
+class Unit:
+    def __init__(self, path):
+        self.path = path
+        self.dies = dwarf(path)
+        self.sizes = {}
+
+    def ref(self, die, attr='DW_AT_type'):
+        m = REF.search(die[2].get(attr, ''))
+        return int(m.group(1), 16) if m else None
+
+    def size(self, off):
+        if off is None:
+            return 0  # void
+        if off not in self.sizes:
+            self.sizes[off] = 0  # a struct that points back at itself
+            self.sizes[off] = self.measure(off)
+        return self.sizes[off]
+
+    def measure(self, off):
+        tag, _, attrs, _ = die = self.dies[off]
+        if tag == 'DW_TAG_base_type':
+            return BASE.get(name_of(attrs['DW_AT_name']), number(attrs.get('DW_AT_byte_size', '0')))
+        if tag == 'DW_TAG_typedef' and name_of(attrs.get('DW_AT_name', '')) in FIXED:
+            return FIXED[name_of(attrs['DW_AT_name'])]
+        if tag in ('DW_TAG_pointer_type', 'DW_TAG_subroutine_type'):
+            return POINTER
+        if tag == 'DW_TAG_enumeration_type':
+            return 2
+        if tag in ('DW_TAG_structure_type', 'DW_TAG_union_type'):
+            members = [self.size(self.ref(d)) for o, d in self.dies.items()
+                       if d[3] == off and d[0] == 'DW_TAG_member']
+            if tag == 'DW_TAG_union_type':
+                return max(members, default=0)
+            return sum(members)
+        if tag == 'DW_TAG_array_type':
+            count = 1
+            for o, d in self.dies.items():
+                if d[3] == off and d[0] == 'DW_TAG_subrange_type':
+                    upper = d[2].get('DW_AT_upper_bound') or d[2].get('DW_AT_count')
+                    count *= number(upper) + (1 if 'DW_AT_upper_bound' in d[2] else 0)
+            return count * self.size(self.ref(die))
+        return self.size(self.ref(die))  # typedef, const, volatile
+
+    def const(self, off):
+        """Whether an object of this type goes in program memory."""
+        while off is not None:
+            tag = self.dies[off][0]
+            if tag == 'DW_TAG_const_type':
+                return True
+            if tag not in ('DW_TAG_typedef', 'DW_TAG_volatile_type', 'DW_TAG_array_type'):
+                return False
+            off = self.ref(self.dies[off])
+        return False
+
+    def named(self, die):
+        """Follow DW_AT_specification/abstract_origin to the DIE with the name and type."""
+        while 'DW_AT_name' not in die[2]:
+            off = self.ref(die, 'DW_AT_specification') or self.ref(die, 'DW_AT_abstract_origin')
+            if off is None:
+                break
+            die = self.dies[off]
+        return die
+
+    def statics(self):
+        for off, die in self.dies.items():
+            if die[0] == 'DW_TAG_variable' and 'DW_OP_addr' in die[2].get('DW_AT_location', ''):
+                d = self.named(die)
+                t = self.ref(d)
+                if not self.const(t):
+                    yield name_of(d[2]['DW_AT_name']), self.size(t)
+
+    def frames(self):
+        """Function name -> bytes of parameters, locals and return value."""
+        owner, frames = {}, {}
+        for off, die in self.dies.items():
+            if die[0] == 'DW_TAG_subprogram' and 'DW_AT_low_pc' in die[2]:
+                d = self.named(die)
+                frames[off] = [name_of(d[2]['DW_AT_name']), self.size(self.ref(d))]
+            parent = die[3]
+            owner[off] = off if off in frames else owner.get(parent)
+        for off, die in self.dies.items():
+            f = owner.get(die[3])
+            if f is None or die[0] not in ('DW_TAG_formal_parameter', 'DW_TAG_variable'):
+                continue
+            if 'DW_OP_addr' in die[2].get('DW_AT_location', ''):
+                continue  # a static local, counted with the statics
+            frames[f][1] += self.size(self.ref(self.named(die)))
+        return dict(frames.values())
+
+
+SECTION = re.compile(r'^Disassembly of section \.text\.(\w+):')
+RELOC = re.compile(r'\s(R_X86_64_\w+)\s+([A-Za-z_]\w*)')
+
+
+def calls(path, functions):
+    """Callees, address-taken functions and indirect callers of one object."""
+    out = subprocess.run(['objdump', '-dr', '--no-show-raw-insn', path],
+                         capture_output=True, text=True, check=True).stdout
+    graph, taken, indirect, current = {}, set(), set(), None
+    for line in out.splitlines():
+        m = SECTION.match(line)
+        if m:
+            current = m.group(1)
+            graph.setdefault(current, set())
+            continue
+        if current is None:
+            continue
+        m = RELOC.search(line)
+        if m and m.group(2) in functions:
+            graph[current].add(m.group(2))
+            if m.group(1) != 'R_X86_64_PLT32':
+                taken.add(m.group(2))
+        elif re.search(r'\tcall\s+\*', line):
+            indirect.add(current)
+    relocs = subprocess.run(['readelf', '-rW', path], capture_output=True, text=True, check=True).stdout
+    section = None
+    for line in relocs.splitlines():
+        m = re.match(r"Relocation section '\.rela(\.\S+)'", line)
+        if m:
+            section = m.group(1)
+            continue
+        if section and not section.startswith('.text'):
+            for word in line.split():
+                if word in functions:
+                    taken.add(word)
+    return graph, taken, indirect
+
+
+def main(argv):
+    verbose = '-v' in argv
+    paths = [a for a in argv if a != '-v']
+    units = [Unit(p) for p in paths]
+
+    frames = {}
+    for u in units:
+        frames.update(u.frames())
+    graph, taken, indirect = {}, set(), set()
+    for p in paths:
+        g, t, i = calls(p, frames)
+        graph.update(g)
+        taken |= t
+        indirect |= i
+    for f in indirect:
+        graph[f] |= taken
+
+    depth, busy = {}, set()
+
+    def chain(f):
+        """Heaviest call chain from f, bytes."""
+        if f in depth:
+            return depth[f]
+        if f in busy:
+            print('memcheck: %s is recursive, XC8 will not compile it' % f)
+            return 0
+        busy.add(f)
+        depth[f] = frames.get(f, 0) + max((chain(c) for c in graph.get(f, ()) if c != f), default=0)
+        busy.discard(f)
+        return depth[f]
+
+    total_static = 0
+    print('%-12s %6s' % ('module', 'static'))
+    for u in units:
+        items = sorted(u.statics(), key=lambda v: -v[1])
+        size = sum(s for _, s in items)
+        total_static += size
+        module = re.sub(r'^.*/|\.o$', '', u.path)
+        print('%-12s %6d  %s' % (module, size,
+                                 ', '.join('%s %d' % v for v in (items if verbose else items[:4]) if v[1])))
+    stack = 0
+    for root in ROOTS:
+        stack += chain(root)
+        print('%-12s %6d  heaviest chain from %s' % ('stack', chain(root), root))
+    used = total_static + stack
+    print('static %d + stack %d = %d of %d bytes (%d kept back), %d to spare'
+          % (total_static, stack, used, RAM_SIZE, RESERVE, RAM_SIZE - RESERVE - used))
+    return 0 if used <= RAM_SIZE - RESERVE else 1
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv[1:]))
@@ -0,0 +1,194 @@
+/* ------------------------------------------------------------------------ *
+ * StruggleBot Monte Carlo mission runner.                                  *
+ *                                                                          *
+ * Runs the firmware through many missions in the world model (world.c),   *
+ * each on a floor, chassis and beacon position picked at random from its   *
+ * seed, and reports how the missions went as a whole:                      *
+ *                                                                          *
+ *   montecarlo [-v] [-n missions] [-s first_seed] [-j jobs] [-t limit_ms]  *
+ *                                                                          *
+ * The firmware keeps its state in globals, so each mission runs in its     *
+ * own process, started from reset, with as many at once as there are      *
+ * CPUs (or -j). The results are the same whatever the number of jobs.      *
+ *                                                                          *
+ * For the time the RFID was read, the time the mission was done and the    *
+ * distance from the start at the end, the 10th, 50th and 90th percentile   *
+ * and the worst are printed, and the missions that never read the tag or   *
+ * never got home (in limit_ms, default 120000) are counted. The seeds of   *
+ * the first failures are listed: strugglebot-sim -v -w seed runs one       *
+ * again on its own. -v prints a line for every mission.                    *
+ * ------------------------------------------------------------------------ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+
+#include "sim.h"
+
+#define MS 1000000ULL
+#define SHOW_FAILURES 10
+
+// firmware main(), renamed by the firmware build
+void firmware_main(void);
+
+struct mission {
+    unsigned long long seed;
+    int ok;                                 // the process finished
+    struct sim_world_result r;
+};
+
+static int resultFd;
+static struct mission run;
+
+static void finish(const char *reason) {
+    sim_world_result(&run.r);
+    run.ok = 1;
+    if (write(resultFd, &run, sizeof run) != sizeof run)
+        perror("montecarlo");
+    _exit(0);
+}
+
+// Start one mission in a child process, its result comes back on *fd
+static pid_t missionStart(unsigned long long seed, unsigned long long limit, int *fd) {
+    struct sim_world world;
+    int fds[2], null;
+    pid_t pid;
+
+    if (pipe(fds) != 0) {
+        perror("pipe");
+        exit(1);
+    }
+    fflush(NULL);
+    pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        exit(1);
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        resultFd = fds[1];
+        null = open("/dev/null", O_WRONLY);
+        dup2(null, 1); // the simulator's own report
+        run.seed = seed;
+        sim_world_random(&world, seed);
+        sim_world_start(&world);
+        sim_stop_on_lcd("DISARM CODE");
+        sim_stop_at(limit * MS);
+        sim_set_finish_hook(finish);
+        firmware_main();
+        sim_finish("firmware returned");
+    }
+    close(fds[1]);
+    *fd = fds[0];
+    return pid;
+}
+
+// Wait for a mission to finish
+static void missionWait(pid_t pid, int fd, struct mission *m) {
+    int status;
+
+    if (read(fd, m, sizeof *m) != sizeof *m)
+        m->ok = 0;
+    close(fd);
+    waitpid(pid, &status, 0);
+}
+
+static int compare(const void *a, const void *b) {
+    double x = *(const double *) a, y = *(const double *) b;
+
+    return (x > y) - (x < y);
+}
+
+// Print the spread of n values
+static void spread(const char *name, double *v, int n) {
+    qsort(v, n, sizeof *v, compare);
+    printf("%-16s %6d", name, n);
+    if (n == 0) {
+        printf("\n");
+        return;
+    }
+    printf(" %9.0f %9.0f %9.0f %9.0f\n", v[n / 10], v[n / 2], v[n * 9 / 10], v[n - 1]);
+}
+
+int main(int argc, char **argv) {
+    long n = 100, jobs = sysconf(_SC_NPROCESSORS_ONLN);
+    unsigned long long first = 1, limit = 120000;
+    int opt, verbose = 0;
+    struct mission *m;
+    pid_t *pids;
+    int *fds;
+    long started = 0, rfid = 0, done = 0, crashed = 0, shown = 0;
+    double *rfidMs, *doneMs, *error;
+
+    while ((opt = getopt(argc, argv, "vn:s:j:t:")) != -1) {
+        switch (opt) {
+            case 'v': verbose = 1; break;
+            case 'n': n = atol(optarg); break;
+            case 's': first = strtoull(optarg, NULL, 0); break;
+            case 'j': jobs = atol(optarg); break;
+            case 't': limit = strtoull(optarg, NULL, 10); break;
+            default:
+                fprintf(stderr, "usage: montecarlo [-v] [-n missions] [-s first_seed] [-j jobs] [-t limit_ms]\n");
+                return 1;
+        }
+    }
+    if (n < 1)
+        n = 1;
+    if (jobs < 1)
+        jobs = 1;
+    m = calloc(n, sizeof *m);
+    pids = calloc(n, sizeof *pids);
+    fds = calloc(n, sizeof *fds);
+    rfidMs = calloc(n, sizeof *rfidMs);
+    doneMs = calloc(n, sizeof *doneMs);
+    error = calloc(n, sizeof *error);
+    if (!m || !pids || !fds || !rfidMs || !doneMs || !error) {
+        perror("montecarlo");
+        return 1;
+    }
+
+    printf("missions %ld (seeds %llu-%llu), %ld jobs, limit %llums\n", n, first, first + n - 1, jobs, limit);
+    if (verbose)
+        printf("%8s %8s %8s %9s %9s %9s %8s\n", "seed", "beacon_m", "deg", "beacon_ms", "rfid_ms", "done_ms", "error_mm");
+    for (long i = 0; i < n; i++) {
+        while (started < n && started - i < jobs) { // keep jobs missions running
+            pids[started] = missionStart(first + started, limit, &fds[started]);
+            started++;
+        }
+        missionWait(pids[i], fds[i], &m[i]); // in order, so the output does not depend on jobs
+        m[i].seed = first + i;
+        if (!m[i].ok) {
+            crashed++;
+            continue;
+        }
+        if (verbose)
+            printf("%8llu %8.2f %8.0f %9lu %9lu %9lu %8.0f\n", m[i].seed, m[i].r.beaconDistance,
+                    m[i].r.beaconBearing, m[i].r.beaconMs, m[i].r.rfidMs, m[i].r.doneMs,
+                    m[i].r.homeError * 1000);
+        if (m[i].r.rfidMs)
+            rfidMs[rfid++] = m[i].r.rfidMs;
+        if (m[i].r.doneMs) {
+            doneMs[done] = m[i].r.doneMs;
+            error[done++] = m[i].r.homeError * 1000;
+        }
+    }
+
+    printf("%-16s %6s %9s %9s %9s %9s\n", "", "count", "p10", "p50", "p90", "max");
+    spread("rfid_ms", rfidMs, rfid);
+    spread("done_ms", doneMs, done);
+    spread("home_error_mm", error, done);
+    printf("failed: tag never read %ld (%.1f%%), not home %ld (%.1f%%), crashed %ld\n",
+            n - crashed - rfid, 100.0 * (n - crashed - rfid) / n, rfid - done, 100.0 * (rfid - done) / n, crashed);
+    for (long i = 0; i < n && shown < SHOW_FAILURES; i++) {
+        if (!m[i].ok || !m[i].r.doneMs) {
+            printf("%s%llu", shown ? " " : "failed seeds: ", m[i].seed);
+            shown++;
+        }
+    }
+    if (shown)
+        printf("\n");
+    return crashed != 0;
+}
@@ -0,0 +1,302 @@
+/* ------------------------------------------------------------------------ *
+ * StruggleBot trace replay.                                                *
+ *                                                                          *
+ * Plays recorded runs back through the firmware. A trace is the telemetry  *
+ * of a run made with TRACE set (TRACE.c): every IR pulse width and RFID    *
+ * byte the robot received, with the tick it arrived at. Each one is fed    *
+ * to the simulated capture inputs and EUSART at the same tick, so the      *
+ * firmware sees exactly the input it saw on the floor, and the run is      *
+ * the same every time:                                                     *
+ *                                                                          *
+ *   strugglebot-replay [-v] [-t after_ms] [-j jobs] trace.bin ...          *
+ *                                                                          *
+ * The robot does not move in the simulator, so the IR readings do not     *
+ * follow a changed steering decision; what a replay shows is how the       *
+ * program reads the input - when it decides the beacon is ahead or lost,   *
+ * which movements it picks, how much of the path log it uses.              *
+ *                                                                          *
+ * Each trace runs in its own process (the firmware starts from reset), as  *
+ * many at once as there are CPUs (or -j), and gets one line: events        *
+ * played, events the robot lost (queue full) and telemetry records missing *
+ * from the file, the ticks at which the beacon was first tracked, the RFID *
+ * was read and the mission was done ('-' if never), the number of movement *
+ * decisions, and the most path log segments used and the unit it ended on. *
+ * After the trace runs out the firmware has after_ms (default 60000) to    *
+ * get home. -v lists the decisions of each run on stderr, one run at a     *
+ * time.                                                                    *
+ * ------------------------------------------------------------------------ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "sim.h"
+
+#define MS 1000000ULL
+
+// keep in step with the TELEM and TRACE sections of HEADER.h
+#define TELEM_SYNC          0xA5
+#define TELEM_TRACE         5
+#define TRACE_EVENT_BYTES   5
+#define TRACE_CAP1          0
+#define TRACE_CAP2          1
+#define TRACE_RX            2
+
+// keep in step with main.c
+#define MISSION_TRACK       2
+#define MISSION_RETURN      3
+#define MISSION_DONE        4
+
+#define NOT_YET             (~0UL)
+
+// firmware main() and state, renamed/declared by the firmware build
+void firmware_main(void);
+extern char mission, moveCode;
+extern unsigned char pathLength __attribute__((weak)); // only with the path log (RETURN_DIRECT 0)
+extern unsigned char pathScale __attribute__((weak));
+
+struct trace_event {
+    unsigned long long at;
+    unsigned char type;
+    unsigned int value;
+};
+
+struct result {
+    unsigned long events, lost, missing;
+    unsigned long beacon, rfid, done;   // ms, NOT_YET if never
+    unsigned long decisions;
+    unsigned int pathMax, pathScale;
+};
+
+static struct trace_event *events;
+static int eventCount, eventNext;
+static unsigned long long endAt;
+static unsigned long long afterMs = 60000;
+static int verbose;
+
+static struct result run;
+static int resultFd;
+static char lastMission, lastMove;
+
+// Read the TELEM_TRACE records of a telemetry file, skipping everything else
+static void loadTrace(const char *path) {
+    FILE *f = fopen(path, "rb");
+    unsigned char *buf;
+    long n, i = 0;
+    unsigned long epoch = 0, last = 0;
+    int lastSeq = -1;
+
+    if (!f) {
+        perror(path);
+        exit(1);
+    }
+    fseek(f, 0, SEEK_END);
+    n = ftell(f);
+    rewind(f);
+    buf = malloc(n + 1);
+    events = malloc((n / TRACE_EVENT_BYTES + 1) * sizeof *events);
+    if (!buf || !events || fread(buf, 1, n, f) != (size_t) n) {
+        perror(path);
+        exit(1);
+    }
+    fclose(f);
+
+    while (i + 3 <= n) {
+        int length = buf[i + 1];
+        unsigned char sum = 0;
+
+        if (buf[i] != TELEM_SYNC || length == 0 || i + length + 3 > n) {
+            i++;
+            continue;
+        }
+        for (int j = 1; j < length + 3; j++)
+            sum += buf[i + j];
+        if (sum != 0) {
+            i++;
+            continue;
+        }
+
+        if (lastSeq >= 0 && buf[i + 3] != ((lastSeq + 1) & 0xFF))
+            run.missing += (buf[i + 3] - lastSeq - 1) & 0xFF; // records lost on the line
+        lastSeq = buf[i + 3];
+
+        if (buf[i + 2] == TELEM_TRACE && length > 3 && (length - 3) % TRACE_EVENT_BYTES == 0) {
+            const unsigned char *p = buf + i + 2;
+
+            run.lost = p[2];
+            for (const unsigned char *e = p + 3; e < p + length; e += TRACE_EVENT_BYTES) {
+                unsigned long tick = e[1] | e[2] << 8;
+
+                if (tick + 0x8000 < last) // the 16 bit tick wrapped
+                    epoch += 0x10000;
+                last = tick;
+                events[eventCount].at = (epoch + tick) * MS;
+                events[eventCount].type = e[0];
+                events[eventCount].value = e[3] | e[4] << 8;
+                eventCount++;
+            }
+        }
+        i += length + 3;
+    }
+    free(buf);
+    run.events = eventCount;
+}
+
+static void finish(void) {
+    if (write(resultFd, &run, sizeof run) != sizeof run)
+        perror("replay");
+    exit(0);
+}
+
+// Note what the firmware has decided since the last look
+static void watch(unsigned long long now) {
+    unsigned long ms = now / MS;
+
+    if (moveCode != lastMove) {
+        run.decisions++;
+        if (verbose)
+            fprintf(stderr, "%8lums  move %d  mission %d\n", ms, moveCode, mission);
+        lastMove = moveCode;
+    }
+    if (mission != lastMission) {
+        if (mission == MISSION_TRACK && run.beacon == NOT_YET)
+            run.beacon = ms;
+        if (mission == MISSION_RETURN && run.rfid == NOT_YET)
+            run.rfid = ms;
+        lastMission = mission;
+    }
+    if (&pathLength && pathLength > run.pathMax)
+        run.pathMax = pathLength;
+    if (&pathScale)
+        run.pathScale = pathScale;
+
+    if (mission == MISSION_DONE) {
+        run.done = ms;
+        finish();
+    }
+    if (now >= endAt)
+        finish();
+}
+
+// Feed the events that are due, and look at the firmware every tick
+static unsigned long long replayHook(unsigned long long now) {
+    unsigned long long next = now + MS;
+
+    while (eventNext < eventCount && events[eventNext].at <= now) {
+        struct trace_event *e = &events[eventNext++];
+        unsigned char byte = e->value;
+
+        if (e->type == TRACE_CAP1 || e->type == TRACE_CAP2)
+            sim_ir_capture(e->type == TRACE_CAP1 ? 0 : 1, e->value);
+        else if (e->type == TRACE_RX)
+            sim_rx_queue(now, &byte, 1);
+    }
+    watch(now);
+    if (eventNext < eventCount && events[eventNext].at < next)
+        next = events[eventNext].at;
+    return next;
+}
+
+// Start one trace in a child process, its result comes back on *fd
+static pid_t replayStart(const char *path, int *fd) {
+    int fds[2];
+    pid_t pid;
+
+    if (pipe(fds) != 0) {
+        perror("pipe");
+        exit(1);
+    }
+    fflush(NULL);
+    pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        exit(1);
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        resultFd = fds[1];
+        run.beacon = run.rfid = run.done = NOT_YET;
+        loadTrace(path);
+        endAt = (eventCount ? events[eventCount - 1].at : 0) + afterMs * MS;
+        sim_ir_period(0); // only the recorded pulses
+        sim_set_event_hook(replayHook);
+        firmware_main();
+        finish();
+    }
+    close(fds[1]);
+    *fd = fds[0];
+    return pid;
+}
+
+// Wait for a trace to finish, returns 0 if it failed
+static int replayWait(pid_t pid, int fd, struct result *r) {
+    ssize_t got = read(fd, r, sizeof *r);
+    int status;
+
+    close(fd);
+    waitpid(pid, &status, 0);
+    return got == sizeof *r && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+static void printMs(unsigned long ms) {
+    if (ms == NOT_YET)
+        printf(" %9s", "-");
+    else
+        printf(" %9lu", ms);
+}
+
+int main(int argc, char **argv) {
+    struct result r;
+    int opt, runs = 0, found = 0, done = 0;
+    long jobs = sysconf(_SC_NPROCESSORS_ONLN);
+    pid_t *pids = malloc(argc * sizeof *pids);
+    int *fds = malloc(argc * sizeof *fds);
+    int started;
+    double toBeacon = 0;
+
+    while ((opt = getopt(argc, argv, "vt:j:")) != -1) {
+        switch (opt) {
+            case 'v': verbose = 1; break;
+            case 't': afterMs = strtoull(optarg, NULL, 10); break;
+            case 'j': jobs = atol(optarg); break;
+            default:
+                fprintf(stderr, "usage: strugglebot-replay [-v] [-t after_ms] [-j jobs] trace.bin ...\n");
+                return 1;
+        }
+    }
+    if (jobs < 1 || verbose)
+        jobs = 1;
+    started = optind;
+
+    printf("%-32s %7s %5s %7s %9s %9s %9s %9s %5s %5s\n", "trace", "events", "lost", "missing",
+            "beacon_ms", "rfid_ms", "done_ms", "decisions", "path", "scale");
+    for (int i = optind; i < argc; i++) {
+        while (started < argc && started - i < jobs) { // keep jobs traces running
+            pids[started] = replayStart(argv[started], &fds[started]);
+            started++;
+        }
+        if (!replayWait(pids[i], fds[i], &r)) { // the results come out in order
+            printf("%-32s failed\n", argv[i]);
+            continue;
+        }
+        printf("%-32s %7lu %5lu %7lu", argv[i], r.events, r.lost, r.missing);
+        printMs(r.beacon);
+        printMs(r.rfid);
+        printMs(r.done);
+        printf(" %9lu %5u %5u\n", r.decisions, r.pathMax, r.pathScale);
+
+        runs++;
+        if (r.beacon != NOT_YET) {
+            found++;
+            toBeacon += r.beacon;
+        }
+        done += r.done != NOT_YET;
+    }
+    printf("%d traces, beacon found in %d", runs, found);
+    if (found)
+        printf(" (mean %.0fms)", toBeacon / found);
+    printf(", mission done in %d\n", done);
+    return runs == argc - optind ? 0 : 1;
+}
@@ -0,0 +1,189 @@
+/* ------------------------------------------------------------------------ *
+ * StruggleBot host simulator - command line and scenario playback.         *
+ *                                                                          *
+ * A scenario is a text file of timed stimulus, one event per line:         *
+ *                                                                          *
+ *   # time_ms  command   arguments                                         *
+ *   0          irperiod  50            beacon pulse interval (ms), 0 none  *
+ *   0          ir        0 0           CAP1/CAP2 pulse widths (16 bit)     *
+ *   1500       ir        50000 50000   high byte 195 = beacon dead ahead   *
+ *   4000       rfid      0000000011    tag frame with checksum, CR, LF     *
+ *   4000       rx        02 41 42      raw bytes on the EUSART RX line     *
+ *   9000       end                                                         *
+ *                                                                          *
+ * and run options that may also be given on the command line:              *
+ *                                                                          *
+ *   stop  DISARM CODE      finish when the text appears on the LCD         *
+ *   limit 60000            finish (exit status 2 if a stop text was set)   *
+ *   cal   kp=80 slew=1     start with a calibration block in the EEPROM,   *
+ *                          the defaults but for these (calimage.c)         *
+ *   tick  0xF000           start the 16 bit 1ms tick (sysTicks) here, to   *
+ *                          run through its wrap without a 65s scenario     *
+ *                                                                          *
+ * -u '' runs to the limit whatever is on the LCD. -e keeps the data        *
+ * EEPROM in a file from one run to the next (calibration, flight           *
+ * recorder). -w seed drives the robot round the world model (world.c)      *
+ * instead of a scenario: the mission montecarlo ran with that seed.        *
+ * ------------------------------------------------------------------------ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "sim.h"
+
+#define MS 1000000ULL
+#define MAX_EVENTS 4096
+
+// firmware main(), renamed by the Makefile, and its tick
+void firmware_main(void);
+extern volatile uint16_t sysTicks;
+
+struct event {
+    unsigned long long at;
+    char command[16];
+    char args[96];
+};
+
+static struct event events[MAX_EVENTS];
+static int eventCount, eventNext;
+static char stopText[64];
+
+static void queueBytes(unsigned long long at, const char *args) {
+    unsigned char data[32];
+    int n = 0;
+    char *end;
+
+    while (*args && n < (int) sizeof data) {
+        unsigned long v = strtoul(args, &end, 16);
+        if (end == args)
+            break;
+        data[n++] = v;
+        args = end;
+    }
+    sim_rx_queue(at, data, n);
+}
+
+static void runEvent(const struct event *e) {
+    unsigned int a, b;
+
+    if (!strcmp(e->command, "ir") && sscanf(e->args, "%u %u", &a, &b) == 2) {
+        sim_ir_set(0, a);
+        sim_ir_set(1, b);
+    } else if (!strcmp(e->command, "irperiod")) {
+        sim_ir_period((unsigned long long) (atof(e->args) * MS));
+    } else if (!strcmp(e->command, "rfid")) {
+        sim_rx_tag(e->at, e->args);
+    } else if (!strcmp(e->command, "rx")) {
+        queueBytes(e->at, e->args);
+    } else if (!strcmp(e->command, "end")) {
+        sim_finish("end");
+    } else {
+        fprintf(stderr, "sim: bad event '%s %s'\n", e->command, e->args);
+        exit(1);
+    }
+}
+
+static unsigned long long playback(unsigned long long now) {
+    while (eventNext < eventCount && events[eventNext].at <= now)
+        runEvent(&events[eventNext++]);
+    return eventNext < eventCount ? events[eventNext].at : ~0ULL;
+}
+
+static void loadScenario(const char *path) {
+    FILE *f = fopen(path, "r");
+    char line[256];
+
+    if (!f) {
+        perror(path);
+        exit(1);
+    }
+    while (fgets(line, sizeof line, f)) {
+        char word[16], *p = strchr(line, '#');
+        int used = 0;
+
+        if (p)
+            *p = 0;
+        line[strcspn(line, "\r\n")] = 0;
+        if (sscanf(line, "%15s %n", word, &used) != 1)
+            continue;
+        if (!strcmp(word, "stop")) {
+            snprintf(stopText, sizeof stopText, "%s", line + used);
+            sim_stop_on_lcd(stopText);
+        } else if (!strcmp(word, "limit")) {
+            sim_stop_at((unsigned long long) (atof(line + used) * MS));
+        } else if (!strcmp(word, "cal")) {
+            unsigned char block[SIM_CAL_BYTES];
+
+            if (!sim_cal_block(block, line + used))
+                exit(1);
+            sim_eeprom_set(SIM_CAL_ADDRESS, block, sizeof block);
+        } else if (!strcmp(word, "tick")) {
+            sysTicks = strtoul(line + used, NULL, 0);
+        } else if (eventCount < MAX_EVENTS) {
+            struct event *e = &events[eventCount++];
+            char *rest = line + used;
+
+            e->at = (unsigned long long) (atof(word) * MS);
+            if (eventCount > 1 && e->at < e[-1].at) {
+                fprintf(stderr, "%s: events must be in time order: %s\n", path, line);
+                exit(1);
+            }
+            if (sscanf(rest, "%15s %n", e->command, &used) != 1) {
+                fprintf(stderr, "%s: missing command: %s\n", path, line);
+                exit(1);
+            }
+            snprintf(e->args, sizeof e->args, "%s", rest + used);
+        }
+    }
+    fclose(f);
+}
+
+static void worldFinish(const char *reason) {
+    sim_world_print();
+}
+
+
+static void usage(void) {
+    fprintf(stderr, "usage: strugglebot-sim [-v] [-t limit_ms] [-u lcd_text] [-x tx_file] [-e eeprom_file] [-w seed | scenario]\n");
+    exit(1);
+}
+
+int main(int argc, char **argv) {
+    const char *limit = NULL, *stop = NULL, *seed = NULL;
+    struct sim_world world;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "vt:u:x:e:w:")) != -1) {
+        switch (opt) {
+            case 'v': sim_verbose = 1; break;
+            case 't': limit = optarg; break;
+            case 'u': stop = optarg; break;
+            case 'x': sim_tx_log(optarg); break;
+            case 'e': sim_eeprom_file(optarg); break;
+            case 'w': seed = optarg; break;
+            default: usage();
+        }
+    }
+    sim_stop_at(120000 * MS);
+    if (seed) {
+        sim_world_random(&world, strtoull(seed, NULL, 0));
+        sim_world_start(&world);
+        sim_set_finish_hook(worldFinish);
+        sim_stop_on_lcd("DISARM CODE");
+    } else {
+        if (optind < argc)
+            loadScenario(argv[optind]);
+        sim_set_event_hook(playback);
+    }
+    if (limit) // command line wins over the scenario file
+        sim_stop_at((unsigned long long) (atof(limit) * MS));
+    if (stop)
+        sim_stop_on_lcd(*stop ? stop : NULL);
+
+    firmware_main();
+    sim_finish("firmware returned");
+    return 0;
+}
@@ -0,0 +1,903 @@
+/* ------------------------------------------------------------------------ *
+ * StruggleBot host simulator - virtual clock and peripheral models.        *
+ *                                                                          *
+ * Models the parts of the PIC18F4331 the firmware relies on:               *
+ *   - interrupt controller (priority levels, GIEH/GIEL, PIR/PIE/IPR)       *
+ *   - Timer2 period match interrupt (the firmware's 1ms tick)              *
+ *   - Timer5 and the IC1/IC2 input capture inputs fed by the IR beacon     *
+ *   - EUSART receiver (2-byte FIFO, overrun) and transmitter               *
+ *   - power control PWM duty/direction decoding for the two motors, and    *
+ *     their speeds (a first order lag behind the drive)                    *
+ *   - the high-speed ADC reading the motors' back-EMF on AN0/AN1, started  *
+ *     by GO or the PWM special event trigger, with the flyback clamp and   *
+ *     the settling after the bridge lets go of a motor                     *
+ *   - the 256 byte data EEPROM (erased at reset, 4ms writes)               *
+ *   - the HD44780 panel wired as in LCD.c, decoded from the port pins      *
+ * ------------------------------------------------------------------------ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+
+#include "xc.h"
+
+// Interrupt service routines in main.c
+void RFIDinterrupt(void);
+void IRinterrupt(void);
+
+#define SIM_SFR_DEFINE(name, bitsType) volatile sim_##name##_t sim_##name;
+SIM_SFRS(SIM_SFR_DEFINE)
+
+volatile unsigned int sim_TXREG = SIM_TXREG_EMPTY;
+
+struct sim_stats sim_stats;
+int sim_verbose;
+
+#define NEVER   (~0ULL)
+#define US      1000ULL
+#define MS      1000000ULL
+
+static unsigned long long now;
+static unsigned long long stopAt = NEVER;
+static const char *stopText;
+static int isrLevel;                    // 0 main line, 1 low priority, 2 high priority
+
+static unsigned long long hookNext = NEVER;
+static unsigned long long (*eventHook)(unsigned long long now);
+static void (*finishHook)(const char *reason);
+
+/*----------------------------------------------------------------------------
+ TIMER2
+ -----------------------------------------------------------------------------*/
+
+static unsigned long long t2Next = NEVER;
+static unsigned char t2Con, t2Pr;       // settings t2Next was scheduled with
+
+// PR2 + 1 counts at the prescaled clock, TMR2IF every TOUTPS + 1 matches
+static unsigned long long t2Period(void) {
+    static const unsigned char prescale[4] = {1, 4, 16, 16};
+
+    return (sim_PR2.reg + 1ULL) * prescale[sim_T2CON.bits.T2CKPS] *
+            (sim_T2CON.bits.TOUTPS + 1) * SIM_TCY_NS;
+}
+
+static void t2Sync(void) {
+    if (!sim_T2CON.bits.TMR2ON) {
+        t2Next = NEVER;
+    } else if (t2Next == NEVER || sim_T2CON.reg != t2Con || sim_PR2.reg != t2Pr) {
+        t2Next = now + t2Period();
+    }
+    t2Con = sim_T2CON.reg;
+    t2Pr = sim_PR2.reg;
+}
+
+static void t2Match(void) {
+    sim_PIR1.bits.TMR2IF = 1;
+    t2Next += t2Period();
+}
+
+/*----------------------------------------------------------------------------
+ TIMER1
+ -----------------------------------------------------------------------------*/
+
+static unsigned long long t1Base;       // virtual time at which TMR1 was zero
+static unsigned int t1Last;             // value last published in TMR1H:TMR1L
+
+static unsigned long long t1TickNs(void) {
+    return SIM_TCY_NS << sim_T1CON.bits.T1CKPS;
+}
+
+// Free running, no overflow interrupt (only the profiler uses it)
+static void t1Sync(void) {
+    unsigned int written = sim_TMR1H.reg << 8 | sim_TMR1L.reg;
+
+    if (written != t1Last) // firmware wrote TMR1 since we last published it
+        t1Base = now - written * t1TickNs();
+    if (sim_T1CON.bits.TMR1ON)
+        t1Last = (unsigned int) ((now - t1Base) / t1TickNs()) & 0xFFFF;
+    else
+        t1Base = now - t1Last * t1TickNs();
+    sim_TMR1H.reg = t1Last >> 8;
+    sim_TMR1L.reg = t1Last & 0xFF;
+}
+
+/*----------------------------------------------------------------------------
+ TIMER5 / INPUT CAPTURE
+ -----------------------------------------------------------------------------*/
+
+static unsigned long long t5Base;       // virtual time at which TMR5 was zero
+static unsigned int t5Last;             // value last published in TMR5H:TMR5L
+
+static unsigned int irWidth[2];
+static unsigned long long irPeriod = 50 * MS;
+static unsigned long long irNext = 50 * MS;
+
+static unsigned long long t5TickNs(void) {
+    return SIM_TCY_NS << sim_T5CON.bits.T5PS;
+}
+
+static void t5Sync(void) {
+    unsigned int written = sim_TMR5H.reg << 8 | sim_TMR5L.reg;
+
+    if (written != t5Last) // firmware wrote TMR5 since we last published it
+        t5Base = now - written * t5TickNs();
+    if (sim_T5CON.bits.TMR5ON)
+        t5Last = (unsigned int) ((now - t5Base) / t5TickNs()) & 0xFFFF;
+    else
+        t5Base = now - t5Last * t5TickNs();
+    sim_TMR5H.reg = t5Last >> 8;
+    sim_TMR5L.reg = t5Last & 0xFF;
+}
+
+// Deliver a pulse to the capture channels in the mask (bit 0 CAP1, bit 1 CAP2)
+static void irCapture(int channels) {
+    if (!sim_T5CON.bits.TMR5ON)
+        return;
+    if ((channels & 1) && sim_CAP1CON.bits.CAP1M) {
+        sim_CAP1BUFH.reg = irWidth[0] >> 8;
+        sim_CAP1BUFL.reg = irWidth[0] & 0xFF;
+        sim_PIR3.bits.IC1IF = 1;
+    }
+    if ((channels & 2) && sim_CAP2CON.bits.CAP2M) {
+        sim_CAP2BUFH.reg = irWidth[1] >> 8;
+        sim_CAP2BUFL.reg = irWidth[1] & 0xFF;
+        sim_PIR3.bits.IC2QEIF = 1;
+    }
+    if (sim_CAP1CON.bits.CAP1REN || sim_CAP2CON.bits.CAP2REN) {
+        t5Base = now;
+        t5Last = 0;
+        sim_TMR5H.reg = 0;
+        sim_TMR5L.reg = 0;
+    }
+}
+
+void sim_ir_set(int channel, unsigned int width) {
+    irWidth[channel & 1] = width;
+}
+
+void sim_ir_period(unsigned long long ns) {
+    irPeriod = ns;
+    irNext = ns ? now + ns : NEVER;
+}
+
+void sim_ir_capture(int channel, unsigned int width) {
+    irWidth[channel & 1] = width;
+    irCapture(1 << (channel & 1));
+}
+
+/*----------------------------------------------------------------------------
+ EUSART
+ -----------------------------------------------------------------------------*/
+
+#define RX_QUEUE 4096
+
+static struct { unsigned long long at; unsigned char data; } rxQueue[RX_QUEUE];
+static int rxHead, rxTail;
+static unsigned long long rxLineFree;   // when the line finishes the byte in flight
+static unsigned long long rxNext = NEVER;
+static unsigned char rxFifo[2];
+static int rxCount;
+static unsigned char rxLast;
+
+static unsigned long long txNext = NEVER;
+static FILE *txLog;
+
+// 10 bit times at the baud rate set by SPBRGH:SPBRG, BRG16 and BRGH
+static unsigned long long byteTime(void) {
+    unsigned long n = sim_SPBRGH.reg << 8 | sim_SPBRG.reg;
+    unsigned long div;
+
+    if (!sim_BAUDCON.bits.BRG16)
+        n &= 0xFF;
+    if (sim_BAUDCON.bits.BRG16 && sim_TXSTA.bits.BRGH)
+        div = 4;
+    else if (sim_BAUDCON.bits.BRG16 || sim_TXSTA.bits.BRGH)
+        div = 16;
+    else
+        div = 64;
+    return 10ULL * 1000000000ULL * div * (n + 1) / SIM_FOSC;
+}
+
+static void rxSchedule(void) {
+    unsigned long long start;
+
+    if (rxHead == rxTail) {
+        rxNext = NEVER;
+        return;
+    }
+    start = rxQueue[rxTail].at > rxLineFree ? rxQueue[rxTail].at : rxLineFree;
+    rxNext = start + byteTime();
+}
+
+static void rxArrive(void) {
+    unsigned char data = rxQueue[rxTail].data;
+
+    rxTail = (rxTail + 1) % RX_QUEUE;
+    rxLineFree = now;
+    if (sim_RCSTA.bits.SPEN && sim_RCSTA.bits.CREN && !sim_RCSTA.bits.OERR) {
+        if (rxCount < 2) {
+            rxFifo[rxCount++] = data;
+        } else {
+            sim_RCSTA.bits.OERR = 1;
+            sim_stats.rxOverruns++;
+        }
+    }
+    sim_PIR1.bits.RCIF = rxCount > 0;
+    rxSchedule();
+}
+
+void sim_rx_queue(unsigned long long at, const unsigned char *data, int len) {
+    while (len--) {
+        if ((rxHead + 1) % RX_QUEUE == rxTail) {
+            fprintf(stderr, "sim: rx queue full\n");
+            return;
+        }
+        rxQueue[rxHead].at = at;
+        rxQueue[rxHead].data = *data++;
+        rxHead = (rxHead + 1) % RX_QUEUE;
+    }
+    if (rxNext == NEVER)
+        rxSchedule();
+}
+
+static int hexNibble(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    c = toupper((unsigned char) c);
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// STX, 10 ASCII hex data, 2 ASCII hex XOR checksum, CR, LF, ETX
+void sim_rx_tag(unsigned long long at, const char *tag) {
+    static const char hex[] = "0123456789ABCDEF";
+    unsigned char frame[16];
+    unsigned char sum = 0;
+
+    if (strlen(tag) != 10) {
+        fprintf(stderr, "sim: rfid tag must be 10 hex digits: %s\n", tag);
+        exit(1);
+    }
+    frame[0] = 0x02;
+    for (int i = 0; i < 10; i++) {
+        if (hexNibble(tag[i]) < 0) {
+            fprintf(stderr, "sim: bad rfid tag %s\n", tag);
+            exit(1);
+        }
+        frame[1 + i] = toupper((unsigned char) tag[i]);
+        if (i & 1)
+            sum ^= hexNibble(tag[i - 1]) << 4 | hexNibble(tag[i]);
+    }
+    frame[11] = hex[sum >> 4];
+    frame[12] = hex[sum & 0x0F];
+    frame[13] = '\r';
+    frame[14] = '\n';
+    frame[15] = 0x03;
+    sim_rx_queue(at, frame, sizeof frame);
+}
+
+unsigned char sim_rcreg_read(void) {
+    if (rxCount) {
+        rxLast = rxFifo[0];
+        rxFifo[0] = rxFifo[1];
+        rxCount--;
+    }
+    sim_PIR1.bits.RCIF = rxCount > 0;
+    return rxLast;
+}
+
+static void rxSync(void) {
+    if (!sim_RCSTA.bits.CREN) // clearing CREN is how firmware clears an overrun
+        sim_RCSTA.bits.OERR = 0;
+    sim_PIR1.bits.RCIF = rxCount > 0; // RCIF is read-only, writes don't stick
+}
+
+static void txSync(void) {
+    if (!sim_TXSTA.bits.TXEN || !sim_RCSTA.bits.SPEN) {
+        sim_TXREG = SIM_TXREG_EMPTY;
+        sim_TXSTA.bits.TRMT = 1;
+    sim_OVDCOND.reg = 0xFF; // the PWM drives every output
+    } else if (sim_TXREG != SIM_TXREG_EMPTY && txNext == NEVER) {
+        // TXREG -> shift register
+        sim_stats.txBytes++;
+        if (txLog)
+            fputc(sim_TXREG, txLog);
+        sim_TXREG = SIM_TXREG_EMPTY;
+        sim_TXSTA.bits.TRMT = 0;
+        txNext = now + byteTime();
+    }
+    sim_PIR1.bits.TXIF = sim_TXSTA.bits.TXEN && sim_TXREG == SIM_TXREG_EMPTY;
+}
+
+void sim_tx_log(const char *path) {
+    txLog = fopen(path, "wb");
+    if (!txLog) {
+        perror(path);
+        exit(1);
+    }
+}
+
+static void txDone(void) {
+    txNext = NEVER;
+    sim_TXSTA.bits.TRMT = 1;
+    txSync();
+}
+
+/*----------------------------------------------------------------------------
+ DATA EEPROM
+ -----------------------------------------------------------------------------*/
+
+#define EE_WRITE_NS (4 * MS)
+
+static unsigned char eeprom[256];
+static unsigned long long eeNext = NEVER;
+static unsigned char eeAddr, eeData;    // write in progress
+
+static void eeSync(void) {
+    if (sim_EECON1.bits.RD) {
+        sim_EEDATA.reg = eeprom[sim_EEADR.reg];
+        sim_EECON1.bits.RD = 0;
+    }
+    if (sim_EECON1.bits.WR && eeNext == NEVER) {
+        if (!sim_EECON1.bits.WREN) { // ignored without WREN
+            sim_EECON1.bits.WR = 0;
+            return;
+        }
+        eeAddr = sim_EEADR.reg;
+        eeData = sim_EEDATA.reg;
+        eeNext = now + EE_WRITE_NS;
+    }
+}
+
+static const char *eeFile; // image loaded at the start and saved at the end, if set
+
+void sim_eeprom_file(const char *path) {
+    FILE *f = fopen(path, "rb");
+
+    eeFile = path;
+    if (f) { // otherwise it starts erased
+        if (fread(eeprom, 1, sizeof eeprom, f) != sizeof eeprom)
+            memset(eeprom, 0xFF, sizeof eeprom);
+        fclose(f);
+    }
+}
+
+void sim_eeprom_set(unsigned char address, const unsigned char *data, int len) {
+    for (int i = 0; i < len; i++)
+        eeprom[(unsigned char) (address + i)] = data[i];
+}
+
+static void eeSave(void) {
+    FILE *f = fopen(eeFile, "wb");
+
+    if (!f || fwrite(eeprom, 1, sizeof eeprom, f) != sizeof eeprom)
+        perror(eeFile);
+    if (f)
+        fclose(f);
+}
+
+static void eeDone(void) {
+    eeprom[eeAddr] = eeData;
+    eeNext = NEVER;
+    sim_EECON1.bits.WR = 0;
+    sim_PIR2.bits.EEIF = 1;
+}
+
+/*----------------------------------------------------------------------------
+ MOTORS (power control PWM)
+ -----------------------------------------------------------------------------*/
+
+static int motorLast[2];
+static unsigned long long motorOffAt[2]; // when each drive last went to 0
+static double motorOffDrive[2];          // and the fraction of full it was before
+
+// Each motor's speed follows its drive through a first order lag, with a
+// deadband and its own gain (load, gearbox)
+static double motorSpeed[2];            // fraction of full speed, + = forwards
+static double motorGain[2] = {1, 1};
+static double motorDeadband[2] = {10, 10};
+static double motorLagNs[2] = {60 * MS, 60 * MS};
+static unsigned long long motorAt;      // time motorSpeed was worked out for
+
+int sim_motor_drive(int channel) {
+    unsigned int pdc, period, frac;
+    int dir;
+
+    int pin = channel ? 3 : 1; // PWM3 and PWM1 drive the bridge
+
+    if (channel) {
+        pdc = sim_PDC1H.reg << 8 | sim_PDC1L.reg;
+        dir = sim_LATB.bits.LB2;
+    } else {
+        pdc = sim_PDC0H.reg << 8 | sim_PDC0L.reg;
+        dir = sim_LATB.bits.LB0;
+    }
+    if (!(sim_OVDCOND.reg >> pin & 1)) { // output overridden, to the OVDCONS level
+        frac = (sim_OVDCONS.reg >> pin & 1) * 1000;
+    } else {
+        if (!(sim_PTCON1.reg & 0x80)) // PTEN
+            return 0;
+        period = ((sim_PTPERH.reg & 0x0F) << 8 | sim_PTPERL.reg) + 1;
+        frac = (pdc & 0x3FFF) * 1000UL / (period * 4);
+        if (frac > 1000)
+            frac = 1000;
+    }
+    // the H-bridge inverts the duty when the direction pin is high
+    return dir ? -(int) (1000 - frac) : (int) frac;
+}
+
+// Bring the motor speeds up to now, at the drives since the last change
+static void motorAdvance(void) {
+    for (int i = 0; i < 2; i++) {
+        double drive = motorLast[i] / 10.0; // %
+        double target = fabs(drive) < motorDeadband[i] ? 0 : drive / 100 * motorGain[i];
+
+        motorSpeed[i] += (target - motorSpeed[i]) * (1 - exp(-(double) (now - motorAt) / motorLagNs[i]));
+    }
+    motorAt = now;
+}
+
+void sim_motor_model(int channel, double gain, double deadband, double lagMs) {
+    motorAdvance();
+    motorGain[channel & 1] = gain;
+    motorDeadband[channel & 1] = deadband;
+    motorLagNs[channel & 1] = lagMs * MS;
+}
+
+double sim_motor_speed(int channel) {
+    motorAdvance();
+    return motorSpeed[channel & 1];
+}
+
+static void motorSync(void) {
+    int l = sim_motor_drive(0), r = sim_motor_drive(1);
+
+    if (l == motorLast[0] && r == motorLast[1])
+        return;
+    motorAdvance(); // at the old drives until now
+    for (int i = 0; i < 2; i++) {
+        if (motorLast[i] && !(i ? r : l)) {
+            motorOffAt[i] = now;
+            motorOffDrive[i] = abs(motorLast[i]) / 1000.0;
+        }
+    }
+    motorLast[0] = l;
+    motorLast[1] = r;
+    sim_stats.motorChanges++;
+    if ((l || r) && !sim_stats.firstMotion)
+        sim_stats.firstMotion = now;
+    if (sim_verbose)
+        printf("%10.3f ms  motors L %5.1f%%  R %5.1f%%\n", now / 1e6, l / 10.0, r / 10.0);
+}
+
+/*----------------------------------------------------------------------------
+ HIGH-SPEED ADC (AN0/AN1 wired to the motors, started by GO or the PWM special event)
+ -----------------------------------------------------------------------------*/
+
+// Only what SPEED.c uses: groups A and B (AN0 and AN1) converted one after
+// the other when GO is set or on every special event trigger, into the 4
+// word FIFO. GO converts at once (the 24us it takes is not modelled). AN0
+// reads the right motor (channel 0) and AN1 the left.
+//
+// While the bridge drives a motor the input is clamped to the supply, and
+// it stays there while the winding current runs down through the flyback
+// diodes once the bridge lets go, which takes ADC_FLYBACK_NS at full drive
+// and less in proportion below it. The off time inside a PWM period is far
+// shorter than that, so any drive at all reads the clamp. After the flyback
+// the input settles onto the back-EMF with the ADC_SETTLE_NS time constant;
+// the back-EMF is ADC_FULL_SPEED at full speed on a nominal floor.
+#define ADC_FULL_SPEED  800     // CAL_EMF_FULL
+#define ADC_SUPPLY      1023
+#define ADC_FLYBACK_NS  (300 * US)
+#define ADC_SETTLE_NS   (50 * US)
+
+static unsigned long long adcNext = NEVER;
+static unsigned char adcCon0, adcCon3, adcPwmCon1, adcCmpL, adcCmpH; // settings adcNext was scheduled with
+static unsigned int adcFifo[4];
+static int adcRead, adcCount;
+
+static unsigned int adcCompare(void) {
+    return (sim_SEVTCMPH.reg & 0x0F) << 8 | sim_SEVTCMPL.reg;
+}
+
+// The next special event trigger after now: PTMR counts from 0 at every
+// PWM period, and matches SEVTCMP once in each, postscaled by SEVOPS + 1
+static void adcSchedule(void) {
+    unsigned long long period = (((sim_PTPERH.reg & 0x0F) << 8 | sim_PTPERL.reg) + 1ULL) * SIM_TCY_NS;
+    unsigned long long every = period * ((sim_PWMCON1.reg >> 4) + 1);
+    unsigned long long offset = adcCompare() * SIM_TCY_NS;
+
+    adcCon0 = sim_ADCON0.reg;
+    adcCon3 = sim_ADCON3.reg;
+    adcPwmCon1 = sim_PWMCON1.reg;
+    adcCmpL = sim_SEVTCMPL.reg;
+    adcCmpH = sim_SEVTCMPH.reg;
+    if (!sim_ADCON0.bits.ADON || !(sim_ADCON3.bits.SSRC & 0x10) || !(sim_PTCON1.reg & 0x80)) {
+        adcNext = NEVER;
+        return;
+    }
+    adcNext = (now / every) * every + offset;
+    if (adcNext <= now)
+        adcNext += every;
+}
+
+// The voltage on AN0/AN1 now, in ADC counts
+static unsigned int adcInput(int channel) {
+    double emf = fabs(sim_motor_speed(channel)) * ADC_FULL_SPEED;
+    double flyback = motorOffDrive[channel] * ADC_FLYBACK_NS;
+    double off = (double) (now - motorOffAt[channel]);
+
+    if (motorLast[channel] || off < flyback)
+        return ADC_SUPPLY;
+    emf += (ADC_SUPPLY - emf) * exp(-(off - flyback) / ADC_SETTLE_NS) + 0.5;
+    return emf > ADC_SUPPLY ? ADC_SUPPLY : (unsigned int) emf;
+}
+
+static void adcShow(void) {
+    unsigned int v = adcFifo[adcRead];
+
+    sim_ADCON1.bits.BFEMT = adcCount == 0;
+    sim_ADCON1.bits.ADPNT = adcRead;
+    if (sim_ADCON2.reg & 0x80) { // right justified
+        sim_ADRESH.reg = v >> 8;
+        sim_ADRESL.reg = v & 0xFF;
+    } else {
+        sim_ADRESH.reg = v >> 2;
+        sim_ADRESL.reg = (v & 3) << 6;
+    }
+}
+
+static void adcConvert(void) {
+    if (adcCount > 2) { // no room for both results
+        sim_ADCON1.bits.BFOVFL = 1;
+        return;
+    }
+    for (int ch = 0; ch < 2; ch++)
+        adcFifo[(adcRead + adcCount++) & 3] = adcInput(ch);
+    sim_PIR1.bits.ADIF = 1;
+    adcShow();
+}
+
+static void adcTrigger(void) {
+    adcSchedule();
+    adcConvert();
+}
+
+unsigned char sim_adresh_read(void) {
+    unsigned char high = sim_ADRESH.reg;
+
+    if (adcCount) {
+        adcRead = (adcRead + 1) & 3;
+        adcCount--;
+    }
+    adcShow();
+    return high;
+}
+
+static void adcSync(void) {
+    if (sim_ADCON0.bits.GO_DONE && sim_ADCON0.bits.ADON) {
+        adcConvert();
+        sim_ADCON0.bits.GO_DONE = 0;
+    }
+    if (sim_ADCON0.reg != adcCon0 || sim_ADCON3.reg != adcCon3 || sim_PWMCON1.reg != adcPwmCon1 ||
+            sim_SEVTCMPL.reg != adcCmpL || sim_SEVTCMPH.reg != adcCmpH ||
+            (adcNext == NEVER && sim_ADCON0.bits.ADON && (sim_PTCON1.reg & 0x80)))
+        adcSchedule();
+    if (!sim_ADCON1.bits.FIFOEN)
+        adcCount = 0;
+    sim_ADCON1.bits.BFEMT = adcCount == 0; // status bits, writes don't stick
+    sim_ADCON1.bits.ADPNT = adcRead;
+}
+
+/*----------------------------------------------------------------------------
+ LCD (HD44780, 4-bit, RS=RA6 E=RC0 DB4=RC1 DB5=RC2 DB6=RD0 DB7=RD1)
+ -----------------------------------------------------------------------------*/
+
+static struct {
+    int en;
+    int fourBit;
+    int haveHigh;
+    unsigned char high;
+    unsigned char ddram[0x80];
+    unsigned char cgram[64];
+    int addr;
+    int cgMode;
+    unsigned long long busyUntil;
+    int changed;
+} lcd;
+
+void sim_lcd_text(char line1[17], char line2[17]) {
+    for (int i = 0; i < 16; i++) {
+        unsigned char a = lcd.ddram[i], b = lcd.ddram[0x40 + i];
+        line1[i] = a < 0x20 ? '#' : a; // custom characters shown as '#'
+        line2[i] = b < 0x20 ? '#' : b;
+    }
+    line1[16] = line2[16] = 0;
+}
+
+static void lcdShow(void) {
+    char l1[17], l2[17];
+
+    sim_lcd_text(l1, l2);
+    printf("%10.3f ms  lcd [%s] [%s]\n", now / 1e6, l1, l2);
+}
+
+static void lcdCheckStop(void) {
+    char l1[17], l2[17];
+
+    sim_lcd_text(l1, l2);
+    if (strstr(l1, stopText) || strstr(l2, stopText))
+        sim_finish("lcd");
+}
+
+static void lcdExecute(int rs, unsigned char b) {
+    unsigned long long busy = 37 * US;
+
+    if (now < lcd.busyUntil)
+        sim_stats.lcdViolations++;
+    if (rs) {
+        if (lcd.cgMode) {
+            lcd.cgram[lcd.addr & 0x3F] = b;
+            lcd.addr = (lcd.addr + 1) & 0x3F;
+        } else {
+            lcd.ddram[lcd.addr & 0x7F] = b;
+            lcd.addr = (lcd.addr + 1) & 0x7F;
+            lcd.changed = 1;
+            if (stopText)
+                lcdCheckStop();
+        }
+        busy = 41 * US;
+    } else if (b & 0x80) {
+        if (lcd.changed && sim_verbose) // print the screen once per update
+            lcdShow();
+        lcd.changed = 0;
+        lcd.addr = b & 0x7F;
+        lcd.cgMode = 0;
+    } else if (b & 0x40) {
+        lcd.addr = b & 0x3F;
+        lcd.cgMode = 1;
+    } else if (b & 0x20) {
+        lcd.fourBit = !(b & 0x10);
+    } else if (b == 0x01 || (b & 0xFE) == 0x02) {
+        if (b == 0x01)
+            memset(lcd.ddram, ' ', sizeof lcd.ddram);
+        lcd.addr = 0;
+        lcd.cgMode = 0;
+        lcd.changed = 1;
+        busy = 1520 * US;
+    }
+    lcd.busyUntil = now + busy;
+}
+
+static void lcdSync(void) {
+    int en = sim_LATC.bits.LC0;
+    unsigned char nibble;
+
+    if (lcd.en && !en) { // data is latched on the falling edge of E
+        nibble = sim_LATC.bits.LC1 | sim_LATC.bits.LC2 << 1 |
+                sim_LATD.bits.LD0 << 2 | sim_LATD.bits.LD1 << 3;
+        if (!lcd.fourBit) {
+            lcdExecute(sim_LATA.bits.LA6, nibble << 4);
+        } else if (!lcd.haveHigh) {
+            lcd.high = nibble;
+            lcd.haveHigh = 1;
+        } else {
+            lcd.haveHigh = 0;
+            lcdExecute(sim_LATA.bits.LA6, lcd.high << 4 | nibble);
+        }
+    }
+    lcd.en = en;
+}
+
+/*----------------------------------------------------------------------------
+ INTERRUPTS
+ -----------------------------------------------------------------------------*/
+
+static void runIsr(int low) {
+    unsigned long long start = now, spent;
+    int level = isrLevel;
+
+    isrLevel = low ? 1 : 2;
+    if (low)
+        sim_INTCON.bits.GIEL = 0;
+    else
+        sim_INTCON.bits.GIEH = 0;
+    sim_delay_ns(SIM_ISR_NS);
+    if (low)
+        IRinterrupt();
+    else
+        RFIDinterrupt();
+    if (low)
+        sim_INTCON.bits.GIEL = 1; // retfie
+    else
+        sim_INTCON.bits.GIEH = 1;
+    isrLevel = level;
+
+    spent = now - start;
+    sim_stats.isrCount[low]++;
+    sim_stats.isrTime[low] += spent;
+    if (spent > sim_stats.isrMax[low])
+        sim_stats.isrMax[low] = spent;
+}
+
+static void dispatch(void) {
+    for (;;) {
+        unsigned char p1 = sim_PIR1.reg & sim_PIE1.reg;
+        unsigned char p2 = sim_PIR2.reg & sim_PIE2.reg;
+        unsigned char p3 = sim_PIR3.reg & sim_PIE3.reg;
+        int high = (p1 & sim_IPR1.reg) || (p2 & sim_IPR2.reg) || (p3 & sim_IPR3.reg);
+        int low = (p1 & ~sim_IPR1.reg) || (p2 & ~sim_IPR2.reg) || (p3 & ~sim_IPR3.reg);
+
+        if (!sim_RCON.bits.IPEN) { // compatibility mode, single vector
+            if ((high || low) && sim_INTCON.bits.GIE && sim_INTCON.bits.PEIE && isrLevel < 2)
+                runIsr(0);
+            else
+                return;
+        } else if (high && sim_INTCON.bits.GIEH && isrLevel < 2) {
+            runIsr(0);
+        } else if (low && sim_INTCON.bits.GIEH && sim_INTCON.bits.GIEL && isrLevel < 1) {
+            runIsr(1);
+        } else {
+            return;
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------
+ VIRTUAL CLOCK
+ -----------------------------------------------------------------------------*/
+
+__attribute__((constructor))
+static void simReset(void) {
+    sim_IPR1.reg = 0xFF; // interrupt priorities reset to high
+    sim_IPR2.reg = 0xFF;
+    sim_IPR3.reg = 0xFF;
+    sim_TXSTA.bits.TRMT = 1;
+    memset(lcd.ddram, ' ', sizeof lcd.ddram);
+    memset(eeprom, 0xFF, sizeof eeprom);
+}
+
+// Pick up everything the firmware changed since the last call
+static void sync(void) {
+    if (now >= MS) // INTOSC stable about 1ms after reset
+        sim_OSCCON.bits.IOFS = 1;
+    t1Sync();
+    t2Sync();
+    t5Sync();
+    rxSync();
+    txSync();
+    motorSync();
+    adcSync();
+    lcdSync();
+    eeSync();
+}
+
+static unsigned long long nextEvent(void) {
+    unsigned long long next = irNext;
+
+    if (t2Next < next) next = t2Next;
+    if (rxNext < next) next = rxNext;
+    if (txNext < next) next = txNext;
+    if (eeNext < next) next = eeNext;
+    if (adcNext < next) next = adcNext;
+    if (hookNext < next) next = hookNext;
+    if (stopAt < next) next = stopAt;
+    return next;
+}
+
+static void runEvents(void) {
+    if (now >= stopAt)
+        sim_finish("time limit");
+    if (now >= hookNext)
+        hookNext = eventHook(now);
+    if (now >= t2Next)
+        t2Match();
+    if (now >= irNext) {
+        irNext += irPeriod;
+        irCapture(3);
+    }
+    if (now >= rxNext)
+        rxArrive();
+    if (now >= txNext)
+        txDone();
+    if (now >= eeNext)
+        eeDone();
+    if (now >= adcNext)
+        adcTrigger();
+}
+
+unsigned long long sim_now(void) {
+    return now;
+}
+
+void sim_delay_ns(unsigned long long ns) {
+    unsigned long long target = now + ns;
+
+    sync();
+    dispatch();
+    while (now < target) {
+        unsigned long long next = nextEvent();
+
+        if (next > target)
+            next = target;
+        if (next > now)
+            now = next;
+        runEvents();
+        sync();
+        dispatch();
+    }
+}
+
+// Any enabled interrupt flag wakes the CPU, whether or not GIEH/GIEL let it in
+static int wakePending(void) {
+    return (sim_PIR1.reg & sim_PIE1.reg) || (sim_PIR2.reg & sim_PIE2.reg) || (sim_PIR3.reg & sim_PIE3.reg);
+}
+
+void sim_sleep(void) {
+    unsigned long isrs = sim_stats.isrCount[0] + sim_stats.isrCount[1];
+    unsigned long long start = now, inIsr = sim_stats.isrTime[0] + sim_stats.isrTime[1], next;
+
+    sync();
+    if (!sim_OSCCON.bits.IDLEN) { // sleep: the oscillator stops and nothing the firmware uses runs
+        if (sim_motor_drive(0) || sim_motor_drive(1)) // the outputs freeze where they are
+            sim_finish("asleep with a motor driven");
+        sim_finish("asleep");
+    }
+    // idle: jump from event to event until one lets an interrupt in
+    while (sim_stats.isrCount[0] + sim_stats.isrCount[1] == isrs && !wakePending()) {
+        next = nextEvent();
+        if (next == NEVER)
+            sim_finish("asleep");
+        sim_delay_ns(next > now ? next - now : SIM_TCY_NS);
+    }
+    sim_stats.idleTime += now - start - (sim_stats.isrTime[0] + sim_stats.isrTime[1] - inIsr); // the ISR that woke it was awake
+}
+
+/*----------------------------------------------------------------------------
+ RUN CONTROL
+ -----------------------------------------------------------------------------*/
+
+void sim_stop_on_lcd(const char *text) {
+    stopText = text;
+}
+
+void sim_stop_at(unsigned long long ns) {
+    stopAt = ns;
+}
+
+void sim_set_event_hook(unsigned long long (*hook)(unsigned long long now)) {
+    eventHook = hook;
+    hookNext = hook ? now : NEVER;
+}
+
+void sim_set_finish_hook(void (*hook)(const char *reason)) {
+    finishHook = hook;
+}
+
+void sim_finish(const char *reason) {
+    char l1[17], l2[17];
+
+    if (finishHook)
+        finishHook(reason);
+    sim_lcd_text(l1, l2);
+    printf("result          %s\n", reason);
+    printf("time_ms         %.3f\n", now / 1e6);
+    printf("first_motion_ms %.3f\n", sim_stats.firstMotion / 1e6);
+    printf("isr_high        count %lu  total_us %.1f  max_us %.1f\n", sim_stats.isrCount[0],
+            sim_stats.isrTime[0] / 1e3, sim_stats.isrMax[0] / 1e3);
+    printf("isr_low         count %lu  total_us %.1f  max_us %.1f\n", sim_stats.isrCount[1],
+            sim_stats.isrTime[1] / 1e3, sim_stats.isrMax[1] / 1e3);
+    printf("motor_changes   %lu\n", sim_stats.motorChanges);
+    printf("lcd_violations  %lu\n", sim_stats.lcdViolations);
+    printf("rx_overruns     %lu\n", sim_stats.rxOverruns);
+    printf("tx_bytes        %lu\n", sim_stats.txBytes);
+    printf("cpu_idle        %.1f%%\n", now ? 100.0 * sim_stats.idleTime / now : 0.0);
+    printf("lcd             [%s] [%s]\n", l1, l2);
+    fflush(stdout);
+    if (txLog)
+        fclose(txLog);
+    if (eeFile)
+        eeSave();
+    exit(strcmp(reason, "time limit") == 0 && stopText ? 2 : 0);
+}
@@ -0,0 +1,172 @@
+/* ------------------------------------------------------------------------ *
+ * StruggleBot host simulator - virtual clock and peripheral models.        *
+ *                                                                          *
+ * Time only moves when the firmware waits: __delay_ms/__delay_us, NOP(),   *
+ * SLEEP() and reads of polled status registers (PIR1/2/3, OSCCON) each     *
+ * advance the virtual clock, and peripheral events (input captures, received       *
+ * bytes, ...) falling inside that window are delivered and their           *
+ * interrupts dispatched in priority order. Code between waits is free.     *
+ * ------------------------------------------------------------------------ */
+
+#ifndef SIM_H
+#define SIM_H
+
+#define SIM_FOSC        8000000UL                   // internal oscillator, as OSCCON = 0x72
+#define SIM_TCY_NS      (4000000000ULL / SIM_FOSC)  // one instruction cycle (500ns)
+#define SIM_ISR_NS      (12 * SIM_TCY_NS)           // vector + context save/restore
+
+#define SIM_TXREG_EMPTY 0x100                       // TXREG value meaning "nothing written"
+
+extern volatile unsigned int sim_TXREG;
+
+/*----------------------------------------------------------------------------
+ VIRTUAL CLOCK
+ -----------------------------------------------------------------------------*/
+
+// Current virtual time since reset, in ns
+unsigned long long sim_now(void);
+
+// Advance virtual time, delivering peripheral events and interrupts
+void sim_delay_ns(unsigned long long ns);
+
+// SLEEP instruction: with IDLEN set, skip to the next interrupt (the peripherals
+// keep running); without it the clock stops for good and the run ends
+void sim_sleep(void);
+
+/*----------------------------------------------------------------------------
+ PERIPHERALS
+ -----------------------------------------------------------------------------*/
+
+// Read side effect of RCREG
+unsigned char sim_rcreg_read(void);
+
+// Read side effect of ADRESH (next result in the ADC FIFO)
+unsigned char sim_adresh_read(void);
+
+// IR beacon as seen by input capture channel 1/2 (16-bit pulse width)
+void sim_ir_set(int channel, unsigned int width);
+
+// Interval between beacon pulses arriving at the capture inputs, 0 for none
+void sim_ir_period(unsigned long long ns);
+
+// One pulse of the given width at one capture input now (trace replay)
+void sim_ir_capture(int channel, unsigned int width);
+
+// Queue bytes on the EUSART RX line, starting no earlier than 'at'
+void sim_rx_queue(unsigned long long at, const unsigned char *data, int len);
+
+// Queue an RFID reader frame for a 10 hex digit tag (checksum, CR, LF and ETX added)
+void sim_rx_tag(unsigned long long at, const char *tag);
+
+// Signed drive of PWM channel 0/1 in 1/1000 of full power (+ = direction pin low)
+int sim_motor_drive(int channel);
+
+// Speed of motor 0/1 for a given drive: gain at full drive, nothing below deadband %, time constant lagMs
+void sim_motor_model(int channel, double gain, double deadband, double lagMs);
+
+// Speed of motor 0/1 now, as a fraction of full speed (+ = direction pin low)
+double sim_motor_speed(int channel);
+
+// Copy of the 2x16 characters currently visible on the LCD
+void sim_lcd_text(char line1[17], char line2[17]);
+
+// Write every byte the EUSART transmits to a file (telemetry, see telemcsv)
+void sim_tx_log(const char *path);
+
+// Load the data EEPROM from a file (erased if it does not exist) and save it back at the end
+void sim_eeprom_file(const char *path);
+
+// Put bytes in the data EEPROM before the run (a calibration block)
+void sim_eeprom_set(unsigned char address, const unsigned char *data, int len);
+
+/*----------------------------------------------------------------------------
+ RUN CONTROL
+ -----------------------------------------------------------------------------*/
+
+struct sim_stats {
+    unsigned long isrCount[2];          // [0] high priority, [1] low priority
+    unsigned long long isrTime[2];      // total virtual time spent inside each ISR
+    unsigned long long isrMax[2];       // longest single ISR invocation
+    unsigned long motorChanges;
+    unsigned long long firstMotion;     // 0 until a motor is first driven
+    unsigned long lcdViolations;        // LCD bytes sent before the previous one finished
+    unsigned long rxOverruns;
+    unsigned long txBytes;
+    unsigned long long idleTime;        // virtual time the CPU spent idling (SLEEP with IDLEN)
+};
+
+extern struct sim_stats sim_stats;
+extern int sim_verbose;
+
+// Stop the run when the given text appears on the LCD (NULL to disable)
+void sim_stop_on_lcd(const char *text);
+
+// Stop the run at the given virtual time
+void sim_stop_at(unsigned long long ns);
+
+// Hook called for every event at its scheduled time (scenario playback)
+void sim_set_event_hook(unsigned long long (*hook)(unsigned long long now));
+
+// Hook called by sim_finish() before the report (world model results)
+void sim_set_finish_hook(void (*hook)(const char *reason));
+
+// Print the end-of-run report and exit
+void sim_finish(const char *reason);
+
+/*----------------------------------------------------------------------------
+ WORLD (world.c)
+ -----------------------------------------------------------------------------*/
+
+// Floor, chassis and beacon of one mission (distances in m, angles in degrees)
+struct sim_world {
+    double beaconX, beaconY;            // post, from the start (robot faces along x)
+    double floorSpeed;                  // track speed on this floor, 1 nominal
+    double trackGain[2];                // right, left track speed for the same drive
+    double deadband;                    // % drive below which a track does not move
+    double lagMs;                       // track speed time constant
+    double turnEfficiency;              // share of the track speed difference that turns the robot
+    double slip;                        // heading drift while moving, degrees per sqrt(s)
+    double irPower;                     // beacon strength, saturates the receivers up to sqrt(irPower) m
+    double irAxis;                      // receivers look this far right (CAP1) and left (CAP2)
+    double irLobe;                      // receiver sensitivity is cos^irLobe off its axis
+    double irNoise;                     // pulse width noise, capture counts
+    double irPeriodMs;                  // between beacon pulses
+    double rfidRange;                   // reader picks up the tag this close to the post
+};
+
+// What happened, ms are 0 if not reached
+struct sim_world_result {
+    unsigned long beaconMs;             // first tracking the beacon
+    unsigned long rfidMs;               // tag read, return started
+    unsigned long doneMs;               // back home, disarm code shown
+    double homeError;                   // m from the start, now
+    double beaconDistance, beaconBearing;
+};
+
+// Pick a random floor, chassis and beacon; the same seed gives the same world
+void sim_world_random(struct sim_world *w, unsigned long long seed);
+
+// Let the world drive the IR and RFID inputs from now on (takes the event hook)
+void sim_world_start(const struct sim_world *w);
+
+// Results so far
+void sim_world_result(struct sim_world_result *r);
+
+// Print the world and the results with the end-of-run report
+void sim_world_print(void);
+
+/*----------------------------------------------------------------------------
+ CALIBRATION BLOCKS (calimage.c)
+ -----------------------------------------------------------------------------*/
+
+#define SIM_CAL_ADDRESS     0x00        // CAL_ADDRESS
+#define SIM_CAL_BYTES       23          // CAL_BYTES
+#define SIM_CAL_WRITE_BYTE  'W'         // CAL_WRITE_BYTE
+
+// Make a block from the defaults and "name=value ..." settings, returns 0 (after saying why) if one is bad
+int sim_cal_block(unsigned char block[SIM_CAL_BYTES], const char *settings);
+
+// The values in a block as "name=value ..." text
+void sim_cal_text(char *out, int size, const unsigned char *block);
+
+#endif /* SIM_H */
@@ -0,0 +1,255 @@
+/* ------------------------------------------------------------------------ *
+ * StruggleBot telemetry decoder.                                           *
+ *                                                                          *
+ * Reads the binary telemetry the firmware sends on the EUSART (TELEM.c)    *
+ * from a file, or stdin, and writes one CSV row per record:                *
+ *                                                                          *
+ *   telemcsv run.bin > run.csv                                             *
+ *   strugglebot-sim -x run.bin scenarios/straight.scn                      *
+ *                                                                          *
+ * Frames are TELEM_SYNC, length, payload, checksum. A frame whose length   *
+ * or checksum is wrong is skipped one byte at a time until the next good   *
+ * one. Bad frames and gaps in the sequence numbers (records the firmware   *
+ * dropped, or bytes lost on the line) are counted on stderr.               *
+ *                                                                          *
+ * The profiler records sent once the mission is done (PROF.c) are not in   *
+ * the CSV: the latest of each is printed on stderr as a table at the end.  *
+ * So is the flight recorder log (FLIGHT.c), as a timeline of its events.   *
+ * Calibration reports (CAL.c) are printed on stderr as they come.          *
+ * ------------------------------------------------------------------------ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim.h"
+
+// keep in step with the TELEM section of HEADER.h
+#define TELEM_SYNC          0xA5
+#define TELEM_STATE         1
+#define TELEM_STATE_LENGTH  15
+#define TELEM_PROFILE       2
+#define TELEM_MARKS         3
+#define TELEM_MARKS_LENGTH  8
+#define TELEM_POWER         6
+#define PROF_PHASES         4
+#define TELEM_POWER_LENGTH  (2 + 4 * PROF_PHASES)
+#define PROF_BINS           12
+#define PROF_PROBES         5
+#define TELEM_PROFILE_LENGTH (13 + 2 * PROF_BINS)
+#define TELEM_FLIGHT        4
+#define FLIGHT_EVENTS       16
+#define FLIGHT_EVENT_BYTES  6
+#define FLIGHT_PART_EVENTS  4
+#define FLIGHT_PARTS        (FLIGHT_EVENTS / FLIGHT_PART_EVENTS)
+#define TELEM_FLIGHT_LENGTH (6 + FLIGHT_PART_EVENTS * FLIGHT_EVENT_BYTES)
+#define TELEM_CAL           7
+#define TELEM_CAL_LENGTH    (3 + SIM_CAL_BYTES)
+#define FRAME_MAX           (255 + 3)
+
+static const char *missions[] = {"start", "search", "track", "return", "done"};
+static const char *probes[PROF_PROBES] = {"ir_isr", "rfid_isr", "motor_pwm", "steer", "tick"};
+static const char *phases[PROF_PHASES] = {"to beacon", "to RFID", "return", "done"};
+static const char *flightTypes[] = {"?", "boot", "mission", "move", "sample", "rfid_ok", "rfid_error"};
+static const char *flightReasons[] = {"?", "mission done", "RFID error", "brown-out"};
+static const char *resets[] = {"power-on", "brown-out", "other"};
+static const char *calStatus[] = {"defaults", "loaded", "written", "rejected"};
+
+// latest profiler records, kept whole
+static unsigned char profile[PROF_PROBES][TELEM_PROFILE_LENGTH];
+static unsigned char marks[TELEM_MARKS_LENGTH];
+static unsigned char power[TELEM_POWER_LENGTH];
+static int haveProfile[PROF_PROBES], haveMarks, havePower;
+
+// latest flight recorder log, events oldest first
+static unsigned char flight[FLIGHT_EVENTS * FLIGHT_EVENT_BYTES];
+static int flightParts, flightCount, flightReason, flightSeq = -1;
+
+static unsigned long records, badFrames, missing;
+static int lastSeq = -1;
+
+static unsigned int u16(const unsigned char *p) {
+    return p[0] | p[1] << 8;
+}
+
+static unsigned long u32(const unsigned char *p) {
+    return u16(p) | (unsigned long) u16(p + 2) << 16;
+}
+
+// Count any records missing before this one
+static int seqOk(int seq) {
+    if (lastSeq >= 0 && seq != ((lastSeq + 1) & 0xFF))
+        missing += (seq - lastSeq - 1) & 0xFF;
+    lastSeq = seq;
+    records++;
+    return seq;
+}
+
+static void state(const unsigned char *p) {
+    int seq = seqOk(p[1]);
+
+    printf("%d,%u,%u,%u,%u,%d,%d,%u,%u,%s,%u\n",
+            seq, u16(p + 2), u16(p + 4), u16(p + 6), p[8],
+            (signed char) p[9], (signed char) p[10], p[11], p[12],
+            p[13] < 5 ? missions[p[13]] : "?", p[14]);
+}
+
+// Decode the frame at the start of buf, returns the bytes used (1 to resync)
+static int frame(const unsigned char *buf, int n) {
+    int length;
+    unsigned char sum = 0;
+
+    if (buf[0] != TELEM_SYNC || n < 3)
+        return 1;
+    length = buf[1];
+    if (length == 0 || n < length + 3)
+        return 1;
+    for (int i = 1; i < length + 3; i++)
+        sum += buf[i];
+    if (sum != 0)
+        return 1;
+
+    if (buf[2] == TELEM_STATE && length == TELEM_STATE_LENGTH) {
+        state(buf + 2);
+    } else if (buf[2] == TELEM_PROFILE && length == TELEM_PROFILE_LENGTH && buf[4] < PROF_PROBES) {
+        seqOk(buf[3]);
+        memcpy(profile[buf[4]], buf + 2, length);
+        haveProfile[buf[4]] = 1;
+    } else if (buf[2] == TELEM_MARKS && length == TELEM_MARKS_LENGTH) {
+        seqOk(buf[3]);
+        memcpy(marks, buf + 2, length);
+        haveMarks = 1;
+    } else if (buf[2] == TELEM_POWER && length == TELEM_POWER_LENGTH) {
+        seqOk(buf[3]);
+        memcpy(power, buf + 2, length);
+        havePower = 1;
+    } else if (buf[2] == TELEM_FLIGHT && length == TELEM_FLIGHT_LENGTH && buf[4] < FLIGHT_PARTS) {
+        seqOk(buf[3]);
+        if (buf[7] != flightSeq) // a different log, start again
+            flightParts = 0;
+        flightSeq = buf[7];
+        flightCount = buf[5];
+        flightReason = buf[6];
+        memcpy(flight + buf[4] * FLIGHT_PART_EVENTS * FLIGHT_EVENT_BYTES, buf + 8,
+                FLIGHT_PART_EVENTS * FLIGHT_EVENT_BYTES);
+        flightParts |= 1 << buf[4];
+    } else if (buf[2] == TELEM_CAL && length == TELEM_CAL_LENGTH) {
+        char text[512];
+
+        seqOk(buf[3]);
+        sim_cal_text(text, sizeof text, buf + 5);
+        fprintf(stderr, "calibration %-8s %s\n", buf[4] < 4 ? calStatus[buf[4]] : "?", text);
+    }
+    return length + 3;
+}
+
+// Print the flight recorder log, one line per event
+static void timeline(void) {
+    const unsigned char *e;
+    unsigned last = 0;
+
+    if (flightSeq < 0)
+        return;
+    fprintf(stderr, "flight log %d, saved at %s, %d events%s\n", flightSeq,
+            flightReason < 4 ? flightReasons[flightReason] : "?", flightCount,
+            flightParts == (1 << FLIGHT_PARTS) - 1 ? "" : " (incomplete)");
+    if (flightCount > FLIGHT_EVENTS)
+        flightCount = FLIGHT_EVENTS;
+    for (int i = FLIGHT_EVENTS - flightCount; i < FLIGHT_EVENTS; i++) {
+        e = flight + i * FLIGHT_EVENT_BYTES;
+        if (!(flightParts & 1 << (i / FLIGHT_PART_EVENTS)))
+            continue;
+        fprintf(stderr, "  %6ums %+6dms  %-10s", u16(e), i == FLIGHT_EVENTS - flightCount ? 0 :
+                (int) ((u16(e) - last) & 0xFFFF), e[2] < 7 ? flightTypes[e[2]] : "?");
+        if (e[2] == 1)
+            fprintf(stderr, " %s reset\n", e[3] < 3 ? resets[e[3]] : "?");
+        else
+            fprintf(stderr, " cap1 %3u cap2 %3u  move %u  %s\n", e[3], e[4], e[5] >> 4,
+                    (e[5] & 0x0F) < 5 ? missions[e[5] & 0x0F] : "?");
+        last = u16(e);
+    }
+}
+
+// Print the profiler results, times in us (a cycle is 0.5us)
+static void report(void) {
+    for (int i = 0; i < PROF_PROBES; i++) {
+        const unsigned char *p = profile[i];
+        unsigned count = u16(p + 7);
+
+        if (!haveProfile[i])
+            continue;
+        if (count == 0) {
+            fprintf(stderr, "%-10s not run\n", probes[i]);
+            continue;
+        }
+        fprintf(stderr, "%-10s %6u runs  min %7.1fus  mean %7.1fus  max %7.1fus  log2 bins:",
+                probes[i], count, u16(p + 3) / 2.0, u32(p + 9) / 2.0 / count, u16(p + 5) / 2.0);
+        for (int b = 0; b < PROF_BINS; b++)
+            fprintf(stderr, " %u", u16(p + 13 + 2 * b));
+        fprintf(stderr, "\n");
+    }
+    if (haveMarks) {
+        unsigned beacon = u16(marks + 2), rfid = u16(marks + 4), home = u16(marks + 6);
+
+        fprintf(stderr, "marks      beacon found %ums, RFID read %ums, home %ums", beacon, rfid, home);
+        if (beacon && rfid && home)
+            fprintf(stderr, " (to beacon %ums, beacon to RFID %ums, return %ums)",
+                    beacon, (unsigned) (rfid - beacon) & 0xFFFF, (unsigned) (home - rfid) & 0xFFFF);
+        fprintf(stderr, "\n");
+    }
+    if (havePower) {
+        unsigned ticks = 0, idle = 0;
+
+        for (int i = 0; i < PROF_PHASES; i++) {
+            unsigned t = u16(power + 2 + 4 * i), s = u16(power + 4 + 4 * i);
+
+            ticks += t;
+            idle += s;
+            if (t)
+                fprintf(stderr, "awake      %-10s %6ums  idle %6ums  awake %5.1f%%\n", phases[i], t, s,
+                        100.0 * (t - (s < t ? s : t)) / t);
+        }
+        if (ticks)
+            fprintf(stderr, "awake      %-10s %6ums  idle %6ums  awake %5.1f%%\n", "total", ticks, idle,
+                    100.0 * (ticks - (idle < ticks ? idle : ticks)) / ticks);
+    }
+}
+
+int main(int argc, char **argv) {
+    FILE *in = stdin;
+    unsigned char buf[2 * FRAME_MAX];
+    int n = 0, c, used;
+
+    if (argc > 2 || (argc == 2 && !(in = fopen(argv[1], "rb")))) {
+        if (argc > 2)
+            fprintf(stderr, "usage: telemcsv [file]\n");
+        else
+            perror(argv[1]);
+        return 1;
+    }
+
+    printf("seq,ticks_ms,cap1,cap2,move,right_pct,left_pct,path_runs,path_scale,mission,dropped\n");
+    for (;;) {
+        while (n < (int) sizeof buf && (c = fgetc(in)) != EOF)
+            buf[n++] = c;
+        if (n == 0)
+            break;
+
+        // a frame only counts once there is enough data for the longest one
+        if (n < FRAME_MAX && !feof(in))
+            continue;
+        used = frame(buf, n);
+        if (used == 1 && buf[0] == TELEM_SYNC && n >= 3 && n >= buf[1] + 3)
+            badFrames++; // looked like a frame but did not check out
+        n -= used;
+        for (int i = 0; i < n; i++)
+            buf[i] = buf[used + i];
+        if (feof(in) && n < 3)
+            break;
+    }
+
+    report();
+    timeline();
+    fprintf(stderr, "telemcsv: %lu records, %lu missing, %lu bad frames\n", records, missing, badFrames);
+    return 0;
+}
@@ -0,0 +1,206 @@
+/* ------------------------------------------------------------------------ *
+ * StruggleBot host simulator - world model.                                *
+ *                                                                          *
+ * Closes the loop around the firmware: the robot moves, and what it sees   *
+ * follows from where it is. Instead of scripted readings:                  *
+ *                                                                          *
+ *   - a two-track chassis driven by the motors (sim_motor_speed). Each     *
+ *     motor's speed follows its drive through a first order lag, with a    *
+ *     deadband and its own gain, times the floor's; skid steering turns    *
+ *     less than the track speeds say (turn efficiency), and the heading    *
+ *     drifts a little as the tracks slip.                                  *
+ *   - a modulated IR beacon on a post. Every pulse reaches each receiver   *
+ *     through a cos^n lobe about the receiver's axis, falling off as 1/d^2 *
+ *     and saturating at the dead-ahead width (195 in the high byte). Too   *
+ *     weak, and there is no pulse at all.                                  *
+ *   - an RFID reader on the front of the robot, which sends the tag frame  *
+ *     every 100ms while it is close enough to the post.                    *
+ *                                                                          *
+ * The robot starts at (0, 0) facing along x. Channel 0 (PDC0, motorL) is   *
+ * the RIGHT track and CAP1 the right receiver, as on the robot.            *
+ *                                                                          *
+ * sim_world_random() picks the floor, chassis and beacon from a seed, so a *
+ * mission can be run again exactly (strugglebot-sim -w seed).              *
+ * ------------------------------------------------------------------------ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "sim.h"
+
+#define MS              1000000ULL
+#define PI              3.14159265358979
+#define DEG             (PI / 180)
+
+#define TRACK_M         0.15    // between the middles of the tracks (ODOM_TRACK_UM)
+#define FULL_SPEED      0.30    // m/s at 100% on a nominal floor (ODOM_UM_PER_PCT)
+#define POST_M          0.05    // radius of the beacon post
+#define NOSE_M          0.10    // centre of the robot to its front (and the reader)
+#define IR_AHEAD        50000   // pulse width when saturated (195 in the high byte)
+#define RFID_REPEAT     (100 * MS)
+#define RFID_TAG        "0000000011"
+
+// firmware state, for the results (keep in step with main.c)
+extern char mission;
+#define MISSION_TRACK   2
+#define MISSION_RETURN  3
+#define MISSION_DONE    4
+
+static struct sim_world w;
+static struct sim_world_result res;
+static double x, y, heading;            // m, radians anticlockwise from x
+static double speed[2];                 // m/s of the right (0) and left (1) track
+static unsigned long long irNext, rfidNext;
+static unsigned long long rng;
+
+/*----------------------------------------------------------------------------
+ RANDOM NUMBERS (xorshift64*, the same on every machine)
+ -----------------------------------------------------------------------------*/
+
+static double uniform(void) {
+    rng ^= rng >> 12;
+    rng ^= rng << 25;
+    rng ^= rng >> 27;
+    return ((rng * 2685821657736338717ULL) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static double between(double lo, double hi) {
+    return lo + (hi - lo) * uniform();
+}
+
+static double gaussian(void) {
+    double u = uniform();
+
+    return sqrt(-2 * log(u > 1e-300 ? u : 1e-300)) * cos(2 * PI * uniform());
+}
+
+void sim_world_random(struct sim_world *p, unsigned long long seed) {
+    double distance, bearing;
+
+    rng = seed * 0x9E3779B97F4A7C15ULL + 1;
+    distance = between(1.0, 3.0);
+    bearing = between(-PI, PI);
+    p->beaconX = distance * cos(bearing);
+    p->beaconY = distance * sin(bearing);
+    p->floorSpeed = between(0.8, 1.1);          // carpet to lino
+    p->trackGain[0] = 1 + 0.05 * gaussian();    // motors and gearboxes differ
+    p->trackGain[1] = 1 + 0.05 * gaussian();
+    p->deadband = between(8, 12);
+    p->lagMs = between(40, 120);
+    p->turnEfficiency = between(0.6, 0.9);
+    p->slip = between(0.5, 2.0);
+    p->irPower = between(4, 9);
+    p->irAxis = between(15, 25);
+    p->irLobe = 4;
+    p->irNoise = between(20, 60);
+    p->irPeriodMs = 50;
+    p->rfidRange = between(0.02, 0.05);
+}
+
+/*----------------------------------------------------------------------------
+ MODEL
+ -----------------------------------------------------------------------------*/
+
+static double wrap(double a) {
+    while (a > PI) a -= 2 * PI;
+    while (a < -PI) a += 2 * PI;
+    return a;
+}
+
+// Move the robot on by dt seconds at the present drives
+static void move(double dt) {
+    double v, turn, nx, ny, before, after;
+
+    for (int i = 0; i < 2; i++)
+        speed[i] = sim_motor_speed(i) * FULL_SPEED;
+
+    v = (speed[0] + speed[1]) / 2;
+    turn = (speed[0] - speed[1]) / TRACK_M * w.turnEfficiency; // right track faster turns anticlockwise
+    heading = wrap(heading + turn * dt + w.slip * DEG * sqrt(dt) * gaussian() * (v != 0 || turn != 0));
+
+    nx = x + v * cos(heading) * dt;
+    ny = y + v * sin(heading) * dt;
+    before = hypot(w.beaconX - x, w.beaconY - y);
+    after = hypot(w.beaconX - nx, w.beaconY - ny);
+    if (after < POST_M + NOSE_M && after < before) // against the post
+        return;
+    x = nx;
+    y = ny;
+}
+
+// A beacon pulse at each receiver that sees it
+static void irPulse(void) {
+    double dx = w.beaconX - x, dy = w.beaconY - y;
+    double d = hypot(dx, dy);
+    double bearing = wrap(atan2(dy, dx) - heading); // anticlockwise (left) positive
+
+    if (d < 0.2)
+        d = 0.2;
+    for (int ch = 0; ch < 2; ch++) {
+        double off = wrap(bearing - (ch == 0 ? -w.irAxis : w.irAxis) * DEG); // CAP1 looks right
+        double s, width;
+
+        if (fabs(off) >= PI / 2)
+            continue;
+        s = w.irPower * pow(cos(off), w.irLobe) / (d * d);
+        if (s < 0.005) // below what the receiver picks up
+            continue;
+        width = (s < 1 ? s : 1) * IR_AHEAD + w.irNoise * gaussian();
+        if (width < 0)
+            width = 0;
+        if (width > 65535)
+            width = 65535;
+        sim_ir_capture(ch, (unsigned int) width);
+    }
+}
+
+static unsigned long long worldHook(unsigned long long now) {
+    unsigned long ms = now / MS;
+
+    move(1e-3);
+    if (now >= irNext) {
+        irPulse();
+        irNext += w.irPeriodMs * MS;
+    }
+    if (hypot(w.beaconX - x, w.beaconY - y) < POST_M + NOSE_M + w.rfidRange && now >= rfidNext) {
+        sim_rx_tag(now, RFID_TAG);
+        rfidNext = now + RFID_REPEAT;
+    }
+
+    if (mission == MISSION_TRACK && res.beaconMs == 0)
+        res.beaconMs = ms;
+    if (mission == MISSION_RETURN && res.rfidMs == 0)
+        res.rfidMs = ms;
+    if (mission == MISSION_DONE && res.doneMs == 0)
+        res.doneMs = ms;
+    return now + MS;
+}
+
+void sim_world_start(const struct sim_world *p) {
+    w = *p;
+    x = y = heading = 0;
+    for (int i = 0; i < 2; i++) // the floor loads both motors
+        sim_motor_model(i, w.floorSpeed * w.trackGain[i], w.deadband, w.lagMs);
+    irNext = sim_now() + w.irPeriodMs * MS;
+    rfidNext = 0;
+    sim_ir_period(0); // the world sends the pulses
+    sim_set_event_hook(worldHook);
+}
+
+void sim_world_result(struct sim_world_result *r) {
+    res.homeError = hypot(x, y);
+    res.beaconDistance = hypot(w.beaconX, w.beaconY);
+    res.beaconBearing = atan2(w.beaconY, w.beaconX) / DEG;
+    *r = res;
+}
+
+void sim_world_print(void) {
+    struct sim_world_result r;
+
+    sim_world_result(&r);
+    printf("world           beacon %.2fm at %.0fdeg  floor %.2f  tracks %.3f %.3f  turn %.2f\n",
+            r.beaconDistance, r.beaconBearing, w.floorSpeed, w.trackGain[0], w.trackGain[1], w.turnEfficiency);
+    printf("world_ms        beacon %lu  rfid %lu  done %lu\n", r.beaconMs, r.rfidMs, r.doneMs);
+    printf("home_error_mm   %.0f\n", r.homeError * 1000);
+}
@@ -0,0 +1,328 @@
+/* ------------------------------------------------------------------------ *
+ * Simulated <xc.h> for the host build of StruggleBot.                      *
+ *                                                                          *
+ * The firmware sources include <xc.h> exactly as they do under XC8. The    *
+ * host build puts this directory first on the include path, so every SFR   *
+ * the firmware touches resolves to a plain variable owned by sim.c, and    *
+ * the delay builtins advance a virtual clock instead of spinning.          *
+ *                                                                          *
+ * Only the registers (and bits) the firmware uses are modelled. Bit names  *
+ * and positions follow the PIC18F4331 datasheet / XC8 device header.       *
+ * ------------------------------------------------------------------------ */
+
+#ifndef SIM_XC_H
+#define SIM_XC_H
+
+#include "sim.h"
+
+/*----------------------------------------------------------------------------
+ XC8 KEYWORDS
+ -----------------------------------------------------------------------------*/
+
+// ISRs become ordinary functions that sim.c calls when an interrupt fires
+#define interrupt
+#define high_priority
+#define low_priority
+#define persistent      // the sim always starts from power-on
+
+#define NOP()       sim_delay_ns(SIM_TCY_NS)
+#define CLRWDT()    NOP()
+#define SLEEP()     sim_sleep()
+#define di()        (INTCONbits.GIE = 0)
+#define ei()        (INTCONbits.GIE = 1)
+
+#define __delay_us(x)   sim_delay_ns((unsigned long long)(x) * 1000ULL)
+#define __delay_ms(x)   sim_delay_ns((unsigned long long)(x) * 1000000ULL)
+#define _delay(x)       sim_delay_ns((unsigned long long)(x) * SIM_TCY_NS)
+
+/*----------------------------------------------------------------------------
+ SFR BIT LAYOUTS
+ -----------------------------------------------------------------------------*/
+
+typedef struct {
+    unsigned b0 : 1, b1 : 1, b2 : 1, b3 : 1, b4 : 1, b5 : 1, b6 : 1, b7 : 1;
+} sim_bits_t;
+
+typedef struct {
+    unsigned LA0 : 1, LA1 : 1, LA2 : 1, LA3 : 1, LA4 : 1, LA5 : 1, LA6 : 1, LA7 : 1;
+} sim_LATAbits_t;
+typedef struct {
+    unsigned LB0 : 1, LB1 : 1, LB2 : 1, LB3 : 1, LB4 : 1, LB5 : 1, LB6 : 1, LB7 : 1;
+} sim_LATBbits_t;
+typedef struct {
+    unsigned LC0 : 1, LC1 : 1, LC2 : 1, LC3 : 1, LC4 : 1, LC5 : 1, LC6 : 1, LC7 : 1;
+} sim_LATCbits_t;
+typedef struct {
+    unsigned LD0 : 1, LD1 : 1, LD2 : 1, LD3 : 1, LD4 : 1, LD5 : 1, LD6 : 1, LD7 : 1;
+} sim_LATDbits_t;
+typedef struct {
+    unsigned RA0 : 1, RA1 : 1, RA2 : 1, RA3 : 1, RA4 : 1, RA5 : 1, RA6 : 1, RA7 : 1;
+} sim_TRISAbits_t;
+typedef struct {
+    unsigned RB0 : 1, RB1 : 1, RB2 : 1, RB3 : 1, RB4 : 1, RB5 : 1, RB6 : 1, RB7 : 1;
+} sim_TRISBbits_t;
+typedef struct {
+    unsigned RC0 : 1, RC1 : 1, RC2 : 1, RC3 : 1, RC4 : 1, RC5 : 1, RC6 : 1, RC7 : 1;
+} sim_TRISCbits_t;
+typedef struct {
+    unsigned RD0 : 1, RD1 : 1, RD2 : 1, RD3 : 1, RD4 : 1, RD5 : 1, RD6 : 1, RD7 : 1;
+} sim_TRISDbits_t;
+typedef struct {
+    unsigned ANS0 : 1, ANS1 : 1, ANS2 : 1, ANS3 : 1, ANS4 : 1, ANS5 : 1, ANS6 : 1, ANS7 : 1;
+} sim_ANSEL0bits_t;
+
+typedef struct {
+    unsigned SCS : 2, IOFS : 1, OSTS : 1, IRCF : 3, IDLEN : 1;
+} sim_OSCCONbits_t;
+typedef union {
+    struct { unsigned BOR : 1, POR : 1, PD : 1, TO : 1, RI : 1, : 2, IPEN : 1; };
+} sim_RCONbits_t;
+typedef union {
+    struct { unsigned RBIF : 1, INT0IF : 1, TMR0IF : 1, RBIE : 1, INT0IE : 1, TMR0IE : 1, PEIE : 1, GIE : 1; };
+    struct { unsigned : 6, GIEL : 1, GIEH : 1; };
+} sim_INTCONbits_t;
+
+typedef union {
+    struct { unsigned TMR1IF : 1, TMR2IF : 1, CCP1IF : 1, SSPIF : 1, TXIF : 1, RCIF : 1, ADIF : 1, : 1; };
+    struct { unsigned : 4, TX1IF : 1, RC1IF : 1; };
+} sim_PIR1bits_t;
+typedef union {
+    struct { unsigned TMR1IE : 1, TMR2IE : 1, CCP1IE : 1, SSPIE : 1, TXIE : 1, RCIE : 1, ADIE : 1, : 1; };
+    struct { unsigned : 4, TX1IE : 1, RC1IE : 1; };
+} sim_PIE1bits_t;
+typedef union {
+    struct { unsigned TMR1IP : 1, TMR2IP : 1, CCP1IP : 1, SSPIP : 1, TXIP : 1, RCIP : 1, ADIP : 1, : 1; };
+    struct { unsigned : 4, TX1IP : 1, RC1IP : 1; };
+} sim_IPR1bits_t;
+typedef struct {
+    unsigned CCP2IF : 1, : 1, LVDIF : 1, : 1, EEIF : 1, : 2, OSCFIF : 1;
+} sim_PIR2bits_t;
+typedef struct {
+    unsigned CCP2IE : 1, : 1, LVDIE : 1, : 1, EEIE : 1, : 2, OSCFIE : 1;
+} sim_PIE2bits_t;
+typedef struct {
+    unsigned CCP2IP : 1, : 1, LVDIP : 1, : 1, EEIP : 1, : 2, OSCFIP : 1;
+} sim_IPR2bits_t;
+typedef struct {
+    unsigned TMR5IF : 1, IC1IF : 1, IC2QEIF : 1, IC3DRIF : 1, PTIF : 1, : 3;
+} sim_PIR3bits_t;
+typedef struct {
+    unsigned TMR5IE : 1, IC1IE : 1, IC2QEIE : 1, IC3DRIE : 1, PTIE : 1, : 3;
+} sim_PIE3bits_t;
+typedef struct {
+    unsigned TMR5IP : 1, IC1IP : 1, IC2QEIP : 1, IC3DRIP : 1, PTIP : 1, : 3;
+} sim_IPR3bits_t;
+
+typedef struct {
+    unsigned TMR1ON : 1, TMR1CS : 1, T1SYNC : 1, T1OSCEN : 1, T1CKPS : 2, T1RUN : 1, RD16 : 1;
+} sim_T1CONbits_t;
+typedef struct {
+    unsigned T2CKPS : 2, TMR2ON : 1, TOUTPS : 4, : 1;
+} sim_T2CONbits_t;
+typedef struct {
+    unsigned TMR5ON : 1, TMR5CS : 1, T5SYNC : 1, T5PS : 2, RESEN : 1, : 1, T5SEN : 1;
+} sim_T5CONbits_t;
+typedef struct {
+    unsigned CAP1M : 4, : 2, CAP1REN : 1, : 1;
+} sim_CAP1CONbits_t;
+typedef struct {
+    unsigned CAP2M : 4, : 2, CAP2REN : 1, : 1;
+} sim_CAP2CONbits_t;
+
+typedef struct {
+    unsigned ADON : 1, GO_DONE : 1, ACMOD : 2, ACSCH : 1, ACONV : 1, : 2;
+} sim_ADCON0bits_t;
+typedef struct {
+    unsigned ADPNT : 2, BFOVFL : 1, BFEMT : 1, FIFOEN : 1, : 1, VCFG : 2;
+} sim_ADCON1bits_t;
+typedef struct {
+    unsigned SSRC : 5, : 1, ADRS : 2;
+} sim_ADCON3bits_t;
+
+typedef struct {
+    unsigned RD : 1, WR : 1, WREN : 1, WRERR : 1, FREE : 1, : 1, CFGS : 1, EEPGD : 1;
+} sim_EECON1bits_t;
+
+typedef struct {
+    unsigned TX9D : 1, TRMT : 1, BRGH : 1, SENDB : 1, SYNC : 1, TXEN : 1, TX9 : 1, CSRC : 1;
+} sim_TXSTAbits_t;
+typedef struct {
+    unsigned RX9D : 1, OERR : 1, FERR : 1, ADDEN : 1, CREN : 1, SREN : 1, RX9 : 1, SPEN : 1;
+} sim_RCSTAbits_t;
+typedef struct {
+    unsigned ABDEN : 1, WUE : 1, : 1, BRG16 : 1, SCKP : 1, : 1, RCIDL : 1, ABDOVF : 1;
+} sim_BAUDCONbits_t;
+
+/*----------------------------------------------------------------------------
+ SFR STORAGE
+ -----------------------------------------------------------------------------*/
+
+// X(name, bit layout) for every modelled SFR; sim.c defines the storage
+#define SIM_SFRS(X)                                                           \
+    X(LATA, sim_LATAbits_t)     X(LATB, sim_LATBbits_t)                       \
+    X(LATC, sim_LATCbits_t)     X(LATD, sim_LATDbits_t)                       \
+    X(TRISA, sim_TRISAbits_t)   X(TRISB, sim_TRISBbits_t)                     \
+    X(TRISC, sim_TRISCbits_t)   X(TRISD, sim_TRISDbits_t)                     \
+    X(ANSEL0, sim_ANSEL0bits_t) X(ANSEL1, sim_bits_t)                         \
+    X(OSCCON, sim_OSCCONbits_t) X(RCON, sim_RCONbits_t)                       \
+    X(INTCON, sim_INTCONbits_t)                                               \
+    X(PIR1, sim_PIR1bits_t)     X(PIE1, sim_PIE1bits_t)   X(IPR1, sim_IPR1bits_t) \
+    X(PIR2, sim_PIR2bits_t)     X(PIE2, sim_PIE2bits_t)   X(IPR2, sim_IPR2bits_t) \
+    X(PIR3, sim_PIR3bits_t)     X(PIE3, sim_PIE3bits_t)   X(IPR3, sim_IPR3bits_t) \
+    X(PTCON0, sim_bits_t)       X(PTCON1, sim_bits_t)                         \
+    X(PWMCON0, sim_bits_t)      X(PWMCON1, sim_bits_t)                        \
+    X(PTPERL, sim_bits_t)       X(PTPERH, sim_bits_t)                         \
+    X(PDC0L, sim_bits_t)        X(PDC0H, sim_bits_t)                          \
+    X(PDC1L, sim_bits_t)        X(PDC1H, sim_bits_t)                          \
+    X(PDC2L, sim_bits_t)        X(PDC2H, sim_bits_t)                          \
+    X(PDC3L, sim_bits_t)        X(PDC3H, sim_bits_t)                          \
+    X(SEVTCMPL, sim_bits_t)     X(SEVTCMPH, sim_bits_t)                       \
+    X(OVDCOND, sim_bits_t)      X(OVDCONS, sim_bits_t)                        \
+    X(ADCON0, sim_ADCON0bits_t) X(ADCON1, sim_ADCON1bits_t)                   \
+    X(ADCON2, sim_bits_t)       X(ADCON3, sim_ADCON3bits_t)                   \
+    X(ADCHS, sim_bits_t)        X(ADRESL, sim_bits_t)     X(ADRESH, sim_bits_t) \
+    X(T1CON, sim_T1CONbits_t)   X(TMR1L, sim_bits_t)      X(TMR1H, sim_bits_t) \
+    X(T2CON, sim_T2CONbits_t)   X(PR2, sim_bits_t)        X(TMR2, sim_bits_t) \
+    X(T5CON, sim_T5CONbits_t)   X(TMR5L, sim_bits_t)      X(TMR5H, sim_bits_t) \
+    X(DFLTCON, sim_bits_t)                                                    \
+    X(CAP1CON, sim_CAP1CONbits_t) X(CAP1BUFL, sim_bits_t) X(CAP1BUFH, sim_bits_t) \
+    X(CAP2CON, sim_CAP2CONbits_t) X(CAP2BUFL, sim_bits_t) X(CAP2BUFH, sim_bits_t) \
+    X(TXSTA, sim_TXSTAbits_t)   X(RCSTA, sim_RCSTAbits_t)                     \
+    X(BAUDCON, sim_BAUDCONbits_t)                                             \
+    X(SPBRG, sim_bits_t)        X(SPBRGH, sim_bits_t)                         \
+    X(EECON1, sim_EECON1bits_t) X(EECON2, sim_bits_t)                         \
+    X(EEADR, sim_bits_t)        X(EEDATA, sim_bits_t)
+
+#define SIM_SFR_DECLARE(name, bitsType)                                       \
+    typedef union { unsigned char reg; bitsType bits; } sim_##name##_t;       \
+    extern volatile sim_##name##_t sim_##name;
+
+SIM_SFRS(SIM_SFR_DECLARE)
+
+// Status registers the firmware busy-waits on cost one instruction per
+// access, so polling loops advance virtual time and let interrupts in
+#define SIM_POLLED(r)   (*(sim_delay_ns(SIM_TCY_NS), &(r)))
+
+#define LATA        (sim_LATA.reg)
+#define LATAbits    (sim_LATA.bits)
+#define LATB        (sim_LATB.reg)
+#define LATBbits    (sim_LATB.bits)
+#define LATC        (sim_LATC.reg)
+#define LATCbits    (sim_LATC.bits)
+#define LATD        (sim_LATD.reg)
+#define LATDbits    (sim_LATD.bits)
+#define TRISA       (sim_TRISA.reg)
+#define TRISAbits   (sim_TRISA.bits)
+#define TRISB       (sim_TRISB.reg)
+#define TRISBbits   (sim_TRISB.bits)
+#define TRISC       (sim_TRISC.reg)
+#define TRISCbits   (sim_TRISC.bits)
+#define TRISD       (sim_TRISD.reg)
+#define TRISDbits   (sim_TRISD.bits)
+#define ANSEL0      (sim_ANSEL0.reg)
+#define ANSEL0bits  (sim_ANSEL0.bits)
+#define ANSEL1      (sim_ANSEL1.reg)
+
+#define OSCCON      (SIM_POLLED(sim_OSCCON).reg)
+#define OSCCONbits  (SIM_POLLED(sim_OSCCON).bits)
+#define RCON        (sim_RCON.reg)
+#define RCONbits    (sim_RCON.bits)
+#define INTCON      (sim_INTCON.reg)
+#define INTCONbits  (sim_INTCON.bits)
+#define PIR1        (SIM_POLLED(sim_PIR1).reg)
+#define PIR1bits    (SIM_POLLED(sim_PIR1).bits)
+#define PIE1        (sim_PIE1.reg)
+#define PIE1bits    (sim_PIE1.bits)
+#define IPR1        (sim_IPR1.reg)
+#define IPR1bits    (sim_IPR1.bits)
+#define PIR2        (SIM_POLLED(sim_PIR2).reg)
+#define PIR2bits    (SIM_POLLED(sim_PIR2).bits)
+#define PIE2        (sim_PIE2.reg)
+#define PIE2bits    (sim_PIE2.bits)
+#define IPR2        (sim_IPR2.reg)
+#define IPR2bits    (sim_IPR2.bits)
+#define PIR3        (SIM_POLLED(sim_PIR3).reg)
+#define PIR3bits    (SIM_POLLED(sim_PIR3).bits)
+#define PIE3        (sim_PIE3.reg)
+#define PIE3bits    (sim_PIE3.bits)
+#define IPR3        (sim_IPR3.reg)
+#define IPR3bits    (sim_IPR3.bits)
+
+#define PTCON0      (sim_PTCON0.reg)
+#define PTCON1      (sim_PTCON1.reg)
+#define PWMCON0     (sim_PWMCON0.reg)
+#define PWMCON1     (sim_PWMCON1.reg)
+#define PTPERL      (sim_PTPERL.reg)
+#define PTPERH      (sim_PTPERH.reg)
+#define PDC0L       (sim_PDC0L.reg)
+#define PDC0H       (sim_PDC0H.reg)
+#define PDC1L       (sim_PDC1L.reg)
+#define PDC1H       (sim_PDC1H.reg)
+#define PDC2L       (sim_PDC2L.reg)
+#define PDC2H       (sim_PDC2H.reg)
+#define PDC3L       (sim_PDC3L.reg)
+#define PDC3H       (sim_PDC3H.reg)
+#define SEVTCMPL    (sim_SEVTCMPL.reg)
+#define SEVTCMPH    (sim_SEVTCMPH.reg)
+#define OVDCOND     (sim_OVDCOND.reg)
+#define OVDCONS     (sim_OVDCONS.reg)
+
+#define ADCON0      (SIM_POLLED(sim_ADCON0).reg) // GO is carried out on the next access
+#define ADCON0bits  (SIM_POLLED(sim_ADCON0).bits)
+#define ADCON1      (sim_ADCON1.reg)
+#define ADCON1bits  (sim_ADCON1.bits)
+#define ADCON2      (sim_ADCON2.reg)
+#define ADCON3      (sim_ADCON3.reg)
+#define ADCON3bits  (sim_ADCON3.bits)
+#define ADCHS       (sim_ADCHS.reg)
+// With the FIFO on, reading ADRESH moves on to the next result (read ADRESL first)
+#define ADRESL      (sim_ADRESL.reg)
+#define ADRESH      (sim_adresh_read())
+
+#define T1CON       (sim_T1CON.reg)
+#define T1CONbits   (sim_T1CON.bits)
+#define TMR1L       (SIM_POLLED(sim_TMR1L).reg) // each read is up to date
+#define TMR1H       (sim_TMR1H.reg)
+#define T2CON       (sim_T2CON.reg)
+#define T2CONbits   (sim_T2CON.bits)
+#define PR2         (sim_PR2.reg)
+#define TMR2        (sim_TMR2.reg)
+#define T5CON       (sim_T5CON.reg)
+#define T5CONbits   (sim_T5CON.bits)
+#define TMR5L       (sim_TMR5L.reg)
+#define TMR5H       (sim_TMR5H.reg)
+#define DFLTCON     (sim_DFLTCON.reg)
+#define CAP1CON     (sim_CAP1CON.reg)
+#define CAP1CONbits (sim_CAP1CON.bits)
+#define CAP1BUFL    (sim_CAP1BUFL.reg)
+#define CAP1BUFH    (sim_CAP1BUFH.reg)
+#define CAP1BUF     ((unsigned int) (sim_CAP1BUFH.reg << 8 | sim_CAP1BUFL.reg))
+#define CAP2CON     (sim_CAP2CON.reg)
+#define CAP2CONbits (sim_CAP2CON.bits)
+#define CAP2BUFL    (sim_CAP2BUFL.reg)
+#define CAP2BUFH    (sim_CAP2BUFH.reg)
+#define CAP2BUF     ((unsigned int) (sim_CAP2BUFH.reg << 8 | sim_CAP2BUFL.reg))
+
+#define TXSTA       (sim_TXSTA.reg)
+#define TXSTAbits   (sim_TXSTA.bits)
+#define RCSTA       (sim_RCSTA.reg)
+#define RCSTAbits   (sim_RCSTA.bits)
+#define BAUDCON     (sim_BAUDCON.reg)
+#define BAUDCONbits (sim_BAUDCON.bits)
+#define SPBRG       (sim_SPBRG.reg)
+#define SPBRGH      (sim_SPBRGH.reg)
+
+// Data EEPROM reads and writes are carried out on the next access, as the
+// firmware always sets RD/WR and then reads EEDATA or polls WR
+#define EECON1      (SIM_POLLED(sim_EECON1).reg)
+#define EECON1bits  (SIM_POLLED(sim_EECON1).bits)
+#define EECON2      (sim_EECON2.reg)
+#define EEADR       (sim_EEADR.reg)
+#define EEDATA      (SIM_POLLED(sim_EEDATA).reg)
+
+// Reading RCREG pops the receive FIFO; TXREG holds SIM_TXREG_EMPTY until
+// the firmware writes a byte into it
+#define RCREG       (sim_rcreg_read())
+#define TXREG       (sim_TXREG)
+
+#endif /* SIM_XC_H */